@@ -0,0 +1,228 @@
+#ifndef BITVECTOR_ARENA_ALLOCATOR_H
+#define BITVECTOR_ARENA_ALLOCATOR_H
+
+#include "bitvector.hpp"
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace bowen
+{
+    // Bump-pointer arena for short-lived vectors, e.g. the temporaries of
+    // one query.  Memory comes from a list of 64-byte aligned blocks; an
+    // allocation only rounds the current pointer up and advances it, and
+    // reset() rewinds to the first block so the next query reuses the same
+    // memory without touching the system allocator.
+    //
+    // Individual frees are not tracked.  The one exception is the most
+    // recent allocation: freeing it moves the pointer back, so temporaries
+    // destroyed in reverse order of creation, as scoped locals are, give
+    // their memory back at once.
+    //
+    // An arena is not thread-safe; BitArena::local() gives every thread its
+    // own.
+    class BitArena
+    {
+    public:
+        static constexpr std::size_t BLOCK_ALIGN = 64;
+        static constexpr std::size_t DEFAULT_BLOCK_BYTES = std::size_t(1) << 20;
+
+    private:
+        struct Block {
+            char* data;
+            std::size_t bytes;
+        };
+
+        std::vector<Block> m_blocks;
+        std::size_t m_block_bytes;
+        std::size_t m_current; // index of the block being carved
+        char* m_ptr;
+        char* m_end;
+        std::size_t m_used;    // bytes handed out in earlier blocks
+
+        static std::uintptr_t align_up(std::uintptr_t p, std::size_t align)
+        {
+            return (p + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+        }
+
+        // Moves to the next retained block that can hold `bytes` at
+        // `align`, or adds a new one.
+        void next_block(std::size_t bytes, std::size_t align)
+        {
+            if (!m_blocks.empty())
+                m_used += static_cast<std::size_t>(m_ptr - m_blocks[m_current].data);
+            for (std::size_t i = m_blocks.empty() ? 0 : m_current + 1; i < m_blocks.size(); ++i) {
+                if (m_blocks[i].bytes >= bytes + align) {
+                    m_current = i;
+                    m_ptr = m_blocks[i].data;
+                    m_end = m_ptr + m_blocks[i].bytes;
+                    return;
+                }
+            }
+            const std::size_t size = std::max(m_block_bytes, bytes + align);
+            void* p = _mm_malloc(size, BLOCK_ALIGN);
+            if (!p) {
+                throw std::bad_alloc();
+            }
+            m_blocks.push_back(Block{static_cast<char*>(p), size});
+            m_current = m_blocks.size() - 1;
+            m_ptr = static_cast<char*>(p);
+            m_end = m_ptr + size;
+        }
+
+    public:
+        explicit BitArena(std::size_t block_bytes = DEFAULT_BLOCK_BYTES)
+            : m_block_bytes(block_bytes), m_current(0), m_ptr(nullptr), m_end(nullptr), m_used(0) {}
+
+        BitArena(const BitArena&) = delete;
+        BitArena& operator=(const BitArena&) = delete;
+
+        ~BitArena()
+        {
+            release();
+        }
+
+        // The calling thread's arena, created on first use.
+        static BitArena& local()
+        {
+            thread_local BitArena arena;
+            return arena;
+        }
+
+        // `align` must be a power of two no larger than BLOCK_ALIGN.
+        void* allocate(std::size_t bytes, std::size_t align)
+        {
+            std::uintptr_t p = align_up(reinterpret_cast<std::uintptr_t>(m_ptr), align);
+            if (!m_ptr || p + bytes > reinterpret_cast<std::uintptr_t>(m_end)) {
+                next_block(bytes, align);
+                p = align_up(reinterpret_cast<std::uintptr_t>(m_ptr), align);
+            }
+            m_ptr = reinterpret_cast<char*>(p + bytes);
+            return reinterpret_cast<void*>(p);
+        }
+
+        // Gives the memory back only when it is the most recent allocation.
+        void deallocate(void* p, std::size_t bytes) noexcept
+        {
+            if (static_cast<char*>(p) + bytes == m_ptr)
+                m_ptr = static_cast<char*>(p);
+        }
+
+        // Rewinds to the first block.  Everything allocated so far becomes
+        // invalid; the blocks are kept for reuse.
+        void reset() noexcept
+        {
+            m_current = 0;
+            m_used = 0;
+            m_ptr = m_blocks.empty() ? nullptr : m_blocks[0].data;
+            m_end = m_blocks.empty() ? nullptr : m_ptr + m_blocks[0].bytes;
+        }
+
+        // Returns every block to the system.
+        void release() noexcept
+        {
+            for (const Block& b : m_blocks)
+                _mm_free(b.data);
+            m_blocks.clear();
+            reset();
+        }
+
+        // Bytes handed out since the last reset, including alignment padding.
+        std::size_t bytes_used() const
+        {
+            return m_blocks.empty() ? 0 : m_used + static_cast<std::size_t>(m_ptr - m_blocks[m_current].data);
+        }
+
+        // Bytes of all blocks held.
+        std::size_t bytes_reserved() const
+        {
+            std::size_t total = 0;
+            for (const Block& b : m_blocks)
+                total += b.bytes;
+            return total;
+        }
+    };
+
+    // Allocator that carves BitVector storage out of a BitArena.  A
+    // default-constructed ArenaAllocator uses the calling thread's arena:
+    //
+    //     {
+    //         BitVector<ArenaAllocator<BitType>> hits = a & b;   // no malloc
+    //         ...
+    //     }
+    //     BitArena::local().reset();                             // end of query
+    //
+    // Vectors must not outlive the next reset() of their arena, and must
+    // stay on the thread that owns it.
+    template<typename T, unsigned int ALIGN_SIZE = 64>
+    class ArenaAllocator
+    {
+        static_assert(ALIGN_SIZE <= BitArena::BLOCK_ALIGN, "arena blocks are only 64-byte aligned");
+
+    private:
+        BitArena* m_arena;
+
+        template<typename U, unsigned int A>
+        friend class ArenaAllocator;
+
+    public:
+        typedef T value_type;
+
+        template<typename U>
+        struct rebind {
+            typedef ArenaAllocator<U, ALIGN_SIZE> other;
+        };
+
+        ArenaAllocator() noexcept
+            : m_arena(&BitArena::local()) {}
+
+        explicit ArenaAllocator(BitArena& arena) noexcept
+            : m_arena(&arena) {}
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U, ALIGN_SIZE>& other) noexcept
+            : m_arena(other.m_arena) {}
+
+        BitArena& arena() const
+        {
+            return *m_arena;
+        }
+
+        T* allocate(std::size_t n)
+        {
+            if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(m_arena->allocate(n * sizeof(T), ALIGN_SIZE));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            m_arena->deallocate(p, n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U, ALIGN_SIZE>& other) const
+        {
+            return m_arena == other.m_arena;
+        }
+
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U, ALIGN_SIZE>& other) const
+        {
+            return m_arena != other.m_arena;
+        }
+    };
+
+    namespace detail
+    {
+        template<typename T, unsigned int ALIGN_SIZE>
+        struct allocator_alignment<ArenaAllocator<T, ALIGN_SIZE>> {
+            static constexpr std::size_t value = ALIGN_SIZE;
+        };
+    } // namespace detail
+
+} // namespace bowen
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef BITVECTOR_ATOMIC_BITVECTOR_H
+#define BITVECTOR_ATOMIC_BITVECTOR_H
+
+#include "bitvector.hpp"
+#include <atomic>
+#include <memory>
+
+namespace bowen
+{
+    // Fixed-size bit vector whose bits may be set, cleared and tested by many
+    // threads at once, e.g. a visited bitmap shared by parallel BFS workers.
+    //
+    // Every word is a std::atomic<BitType>.  set/clear/test_and_set are single
+    // locked read-modify-writes (`lock or`, `lock and`, or `lock bts` when only
+    // the old bit is used), so concurrent writers never lose updates the way
+    // BitReference's plain read-modify-write does.  test() is a relaxed load
+    // and compiles to the same plain `mov` as BitVector::operator[].
+    //
+    // test_and_set first checks the bit with a relaxed load and only issues
+    // the locked instruction when the bit is still clear, so threads that
+    // mostly revisit set bits share the cache line instead of bouncing it.
+    //
+    // Memory orders default to acq_rel for the read-modify-writes and relaxed
+    // for test(); pass a stronger order to publish other data with a bit.
+    class AtomicBitVector
+    {
+    private:
+        typedef std::atomic<BitType> Word;
+        static_assert(sizeof(Word) == sizeof(BitType), "atomic words must not add padding");
+
+        std::unique_ptr<Word[]> m_data;
+        size_t m_size;
+
+        static size_t num_words(size_t bits)
+        {
+            return (bits + WORD_BITS - 1) / WORD_BITS;
+        }
+
+        static BitType mask(size_t pos)
+        {
+            return static_cast<BitType>(1) << (pos & (WORD_BITS - 1));
+        }
+
+        // Ordering for the plain load that lets test_and_set/test_and_clear
+        // return early: the acquire half of `order`, so an early `true`
+        // synchronizes with the writer just as the read-modify-write would.
+        static std::memory_order load_order(std::memory_order order)
+        {
+            switch (order) {
+                case std::memory_order_seq_cst: return std::memory_order_seq_cst;
+                case std::memory_order_consume:
+                case std::memory_order_acquire:
+                case std::memory_order_acq_rel: return std::memory_order_acquire;
+                default: return std::memory_order_relaxed;
+            }
+        }
+
+        void check_pos(size_t pos) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= m_size){
+                std::stringstream  ss;
+                ss << "AtomicBitVector index out of range" << " pos: " << pos << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#else
+            (void)pos;
+#endif
+        }
+
+        void check_word(size_t index) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (index >= num_words(m_size)){
+                std::stringstream  ss;
+                ss << "AtomicBitVector word index out of range" << " index: " << index << " words: " << num_words(m_size) << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#else
+            (void)index;
+#endif
+        }
+
+    public:
+        AtomicBitVector()
+            : m_size(0) {}
+
+        explicit AtomicBitVector(size_t n, bool value = false)
+            : m_data(new Word[num_words(n)]), m_size(n)
+        {
+            const BitType fill = value ? ~static_cast<BitType>(0) : 0;
+            for (size_t i = 0; i < num_words(n); ++i)
+                m_data[i].store(fill, std::memory_order_relaxed);
+        }
+
+        // Snapshot of a BitVector.  Not atomic with respect to writers of
+        // `other`.
+        template<typename Allocator, std::size_t InlineBits>
+        explicit AtomicBitVector(const BitVector<Allocator, InlineBits>& other)
+            : m_data(new Word[num_words(other.size())]), m_size(other.size())
+        {
+            const BitType* src = other.data();
+            for (size_t i = 0; i < num_words(m_size); ++i)
+                m_data[i].store(src[i], std::memory_order_relaxed);
+        }
+
+        AtomicBitVector(AtomicBitVector&& other) noexcept
+            : m_data(std::move(other.m_data)), m_size(other.m_size)
+        {
+            other.m_size = 0;
+        }
+
+        AtomicBitVector& operator=(AtomicBitVector&& other) noexcept
+        {
+            m_data = std::move(other.m_data);
+            m_size = other.m_size;
+            other.m_size = 0;
+            return *this;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        size_t word_count() const
+        {
+            return num_words(m_size);
+        }
+
+        bool test(size_t pos, std::memory_order order = std::memory_order_relaxed) const
+        {
+            check_pos(pos);
+            return (m_data[pos >> WORD_SHIFT].load(order) & mask(pos)) != 0;
+        }
+
+        bool operator[](size_t pos) const
+        {
+            return test(pos);
+        }
+
+        void set(size_t pos, std::memory_order order = std::memory_order_acq_rel)
+        {
+            check_pos(pos);
+            m_data[pos >> WORD_SHIFT].fetch_or(mask(pos), order);
+        }
+
+        void clear(size_t pos, std::memory_order order = std::memory_order_acq_rel)
+        {
+            check_pos(pos);
+            m_data[pos >> WORD_SHIFT].fetch_and(~mask(pos), order);
+        }
+
+        // Sets the bit and returns its previous value.  Exactly one of several
+        // threads racing on a clear bit sees false.
+        bool test_and_set(size_t pos, std::memory_order order = std::memory_order_acq_rel)
+        {
+            check_pos(pos);
+            Word& word = m_data[pos >> WORD_SHIFT];
+            const BitType m = mask(pos);
+            if (word.load(load_order(order)) & m)
+                return true;
+            return (word.fetch_or(m, order) & m) != 0;
+        }
+
+        // Clears the bit and returns its previous value.
+        bool test_and_clear(size_t pos, std::memory_order order = std::memory_order_acq_rel)
+        {
+            check_pos(pos);
+            Word& word = m_data[pos >> WORD_SHIFT];
+            const BitType m = mask(pos);
+            if (!(word.load(load_order(order)) & m))
+                return false;
+            return (word.fetch_and(~m, order) & m) != 0;
+        }
+
+        // ORs `bits` into word `index` and returns the word's previous value;
+        // `bits & ~previous` are the bits this call newly set.
+        BitType fetch_or_word(size_t index, BitType bits, std::memory_order order = std::memory_order_acq_rel)
+        {
+            check_word(index);
+            return m_data[index].fetch_or(bits, order);
+        }
+
+        BitType fetch_and_word(size_t index, BitType bits, std::memory_order order = std::memory_order_acq_rel)
+        {
+            check_word(index);
+            return m_data[index].fetch_and(bits, order);
+        }
+
+        BitType load_word(size_t index, std::memory_order order = std::memory_order_relaxed) const
+        {
+            check_word(index);
+            return m_data[index].load(order);
+        }
+
+        // Number of set bits.  Concurrent writers may or may not be counted.
+        size_t count() const
+        {
+            const size_t full = m_size >> WORD_SHIFT;
+            size_t total = 0;
+            for (size_t i = 0; i < full; ++i)
+                total += detail::popcount_word(m_data[i].load(std::memory_order_relaxed));
+            if (m_size & (WORD_BITS - 1))
+                total += detail::popcount_word(m_data[full].load(std::memory_order_relaxed) & detail::tail_mask(m_size));
+            return total;
+        }
+
+        // Stores `value` into every word.  Must not race with other writers.
+        void reset(bool value = false)
+        {
+            const BitType fill = value ? ~static_cast<BitType>(0) : 0;
+            for (size_t i = 0; i < num_words(m_size); ++i)
+                m_data[i].store(fill, std::memory_order_relaxed);
+        }
+
+        // Copies the current bits into a plain BitVector.
+        template<typename Allocator = std::allocator<BitType>>
+        BitVector<Allocator> to_bitvector() const
+        {
+            BitVector<Allocator> out(m_size);
+            BitType* dst = out.data();
+            for (size_t i = 0; i < num_words(m_size); ++i)
+                dst[i] = m_data[i].load(std::memory_order_relaxed);
+            return out;
+        }
+    };
+
+} // namespace bowen
+
+#endif
@@ -0,0 +1,460 @@
+#ifndef BITVECTOR_BIT_ARRAY_H
+#define BITVECTOR_BIT_ARRAY_H
+
+#include "bitvector.hpp"
+#include <cstdint>
+#include <utility>
+
+namespace bowen
+{
+    namespace detail
+    {
+        // constexpr counterparts of popcount_word, _tzcnt_u64 and
+        // highest_bit; the builtins compile to the same instructions.
+        constexpr std::size_t popcount_constexpr(BitType w)
+        {
+#if defined(__GNUC__)
+            return static_cast<std::size_t>(__builtin_popcountl(w));
+#else
+            w = w - ((w >> 1) & 0x5555555555555555ull);
+            w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+            w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0full;
+            return static_cast<std::size_t>((w * 0x0101010101010101ull) >> 56);
+#endif
+        }
+
+        // w must be non-zero.
+        constexpr std::size_t lowest_bit_constexpr(BitType w)
+        {
+#if defined(__GNUC__)
+            return static_cast<std::size_t>(__builtin_ctzl(w));
+#else
+            std::size_t n = 0;
+            while (!(w & 1)) {
+                w >>= 1;
+                ++n;
+            }
+            return n;
+#endif
+        }
+
+        // w must be non-zero.
+        constexpr std::size_t highest_bit_constexpr(BitType w)
+        {
+#if defined(__GNUC__)
+            return static_cast<std::size_t>(WORD_BITS - 1 - __builtin_clzl(w));
+#else
+            std::size_t n = 0;
+            while (w >>= 1)
+                ++n;
+            return n;
+#endif
+        }
+    } // namespace detail
+
+    // Fixed-size bit array whose size N is a compile-time constant.  The
+    // words live inside the object, construction and every query are
+    // constexpr, and the word loops (bitwise operators, comparisons, the
+    // find family) are expanded by fold expressions into one statement per
+    // word, so the compiler sees straight-line code it can keep in
+    // registers.  count() keeps a loop of WORDS iterations; see
+    // count_words.
+    //
+    //     constexpr bowen::BitArray<256> mask = bowen::BitArray<256>().set_range(8, 24);
+    //     static_assert(mask.count() == 16, "");
+    //
+    // Unlike BitVector, bits past N are always zero.
+    template<std::size_t N>
+    class BitArray
+    {
+        static_assert(N > 0, "BitArray needs at least one bit");
+
+    public:
+        static constexpr std::size_t WORDS = (N + WORD_BITS - 1) / WORD_BITS;
+
+        // Returned by the find_* family when no matching bit exists.
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    private:
+        typedef std::make_index_sequence<WORDS> word_indices;
+
+        static constexpr BitType ALL_ONES = ~static_cast<BitType>(0);
+        static constexpr BitType LAST_MASK = (N & (WORD_BITS - 1)) ? (static_cast<BitType>(1) << (N & (WORD_BITS - 1))) - 1 : ALL_ONES;
+
+        BitType m_words[WORDS] = {};
+
+        // The messages are built outside the constexpr checks, which may not
+        // declare a stringstream.
+        [[noreturn]] static void throw_index(std::size_t pos)
+        {
+            std::stringstream  ss;
+            ss << "BitArray index out of range" << " pos: " << pos << " size: " << N << std::endl;
+            throw std::out_of_range(ss.str());
+        }
+
+        [[noreturn]] static void throw_range(std::size_t l, std::size_t r)
+        {
+            std::stringstream  ss;
+            ss << "BitArray range out of range" << " l: " << l << " r: " << r << " size: " << N << std::endl;
+            throw std::out_of_range(ss.str());
+        }
+
+        constexpr void check_pos(std::size_t pos) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= N)
+                throw_index(pos);
+#else
+            (void)pos;
+#endif
+        }
+
+        constexpr void check_range(std::size_t l, std::size_t r) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (l > r || r > N)
+                throw_range(l, r);
+#else
+            (void)l;
+            (void)r;
+#endif
+        }
+
+        // Mask of the bits of [l, r) that fall in word i.
+        static constexpr BitType range_mask(std::size_t i, std::size_t l, std::size_t r)
+        {
+            const std::size_t lo = i << WORD_SHIFT;
+            const std::size_t hi = lo + WORD_BITS;
+            if (r <= lo || l >= hi)
+                return 0;
+            const BitType head = l <= lo ? ALL_ONES : ALL_ONES << (l - lo);
+            const BitType tail = r >= hi ? ALL_ONES : (static_cast<BitType>(1) << (r - lo)) - 1;
+            return head & tail;
+        }
+
+        template<std::size_t... I>
+        constexpr void fill_words(BitType value, std::index_sequence<I...>)
+        {
+            ((m_words[I] = I + 1 == WORDS ? value & LAST_MASK : value), ...);
+        }
+
+        template<typename Op, std::size_t... I>
+        constexpr void apply_words(const BitArray& other, Op op, std::index_sequence<I...>)
+        {
+            ((m_words[I] = op(m_words[I], other.m_words[I])), ...);
+        }
+
+        template<std::size_t... I>
+        constexpr void flip_words(std::index_sequence<I...>)
+        {
+            ((m_words[I] = I + 1 == WORDS ? ~m_words[I] & LAST_MASK : ~m_words[I]), ...);
+        }
+
+        template<std::size_t... I>
+        constexpr void range_words(std::size_t l, std::size_t r, detail::range_op op, std::index_sequence<I...>)
+        {
+            ((m_words[I] = op == detail::range_op::set ? m_words[I] | range_mask(I, l, r)
+                         : op == detail::range_op::clear ? m_words[I] & ~range_mask(I, l, r)
+                                                         : m_words[I] ^ range_mask(I, l, r)), ...);
+        }
+
+        // A loop with a constant trip count rather than a fold: the
+        // compiler's loop vectorizer turns it into vpopcntq or the AVX2
+        // nibble-lookup popcount, which it does not do for a chain of adds.
+        constexpr std::size_t count_words() const
+        {
+            std::size_t total = 0;
+            for (std::size_t i = 0; i < WORDS; ++i)
+                total += detail::popcount_constexpr(m_words[i]);
+            return total;
+        }
+
+        template<std::size_t... I>
+        constexpr bool any_words(std::index_sequence<I...>) const
+        {
+            return (... || (m_words[I] != 0));
+        }
+
+        template<std::size_t... I>
+        constexpr bool all_words(std::index_sequence<I...>) const
+        {
+            return (... && (m_words[I] == (I + 1 == WORDS ? LAST_MASK : ALL_ONES)));
+        }
+
+        template<std::size_t... I>
+        constexpr bool equal_words(const BitArray& other, std::index_sequence<I...>) const
+        {
+            return (... && (m_words[I] == other.m_words[I]));
+        }
+
+        // First set (or, with Zero, clear) bit at or after pos.  The fold
+        // stops at the first word that has one.
+        template<bool Zero, std::size_t... I>
+        constexpr std::size_t find_next_words(std::size_t pos, std::index_sequence<I...>) const
+        {
+            const std::size_t first = pos >> WORD_SHIFT;
+            const BitType head = ALL_ONES << (pos & (WORD_BITS - 1));
+            std::size_t found = npos;
+            (... || [&] {
+                if (I < first)
+                    return false;
+                BitType w = Zero ? ~m_words[I] : m_words[I];
+                if (I + 1 == WORDS)
+                    w &= LAST_MASK;
+                if (I == first)
+                    w &= head;
+                if (!w)
+                    return false;
+                found = (I << WORD_SHIFT) + detail::lowest_bit_constexpr(w);
+                return true;
+            }());
+            return found;
+        }
+
+        // Last set (or clear) bit before pos, scanning the words downwards.
+        template<bool Zero>
+        constexpr std::size_t find_prev_words(std::size_t pos) const
+        {
+            if (pos == 0)
+                return npos;
+            const std::size_t last = pos - 1;
+            for (std::size_t i = (last >> WORD_SHIFT) + 1; i-- > 0;) {
+                BitType w = Zero ? ~m_words[i] : m_words[i];
+                if (i + 1 == WORDS)
+                    w &= LAST_MASK;
+                if (i == (last >> WORD_SHIFT))
+                    w &= ALL_ONES >> (WORD_BITS - 1 - (last & (WORD_BITS - 1)));
+                if (w)
+                    return (i << WORD_SHIFT) + detail::highest_bit_constexpr(w);
+            }
+            return npos;
+        }
+
+    public:
+        constexpr BitArray() = default;
+
+        constexpr explicit BitArray(bool value)
+        {
+            fill_words(value ? ALL_ONES : 0, word_indices());
+        }
+
+        // Copies a BitVector of exactly N bits.
+        template<typename Allocator, std::size_t InlineBits>
+        explicit BitArray(const BitVector<Allocator, InlineBits>& bits)
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (bits.size() != N){
+                std::stringstream  ss;
+                ss << "BitArray size mismatch" << " size: " << N << " vector: " << bits.size() << std::endl;
+                throw std::invalid_argument(ss.str());
+            }
+#endif
+            const BitType* src = bits.data();
+            for (std::size_t i = 0; i < WORDS; ++i)
+                m_words[i] = src[i];
+            m_words[WORDS - 1] &= LAST_MASK;
+        }
+
+        template<typename Allocator = std::allocator<BitType>>
+        BitVector<Allocator> to_bitvector() const
+        {
+            BitVector<Allocator> out(N);
+            std::copy(m_words, m_words + WORDS, out.data());
+            return out;
+        }
+
+        static constexpr std::size_t size()
+        {
+            return N;
+        }
+
+        constexpr const BitType* data() const
+        {
+            return m_words;
+        }
+
+        constexpr BitType word(std::size_t i) const
+        {
+            return m_words[i];
+        }
+
+        constexpr bool operator[](std::size_t pos) const
+        {
+            check_pos(pos);
+            return (m_words[pos >> WORD_SHIFT] >> (pos & (WORD_BITS - 1))) & 1;
+        }
+
+        BitReference<> operator[](std::size_t pos)
+        {
+            check_pos(pos);
+            return BitReference<>(&m_words[pos >> WORD_SHIFT], static_cast<BitType>(1) << (pos & (WORD_BITS - 1)));
+        }
+
+        constexpr BitArray& set_bit(std::size_t pos, bool value = true)
+        {
+            check_pos(pos);
+            const BitType mask = static_cast<BitType>(1) << (pos & (WORD_BITS - 1));
+            if (value)
+                m_words[pos >> WORD_SHIFT] |= mask;
+            else
+                m_words[pos >> WORD_SHIFT] &= ~mask;
+            return *this;
+        }
+
+        // Stores `value` into every bit.
+        constexpr BitArray& reset(bool value = false)
+        {
+            fill_words(value ? ALL_ONES : 0, word_indices());
+            return *this;
+        }
+
+        constexpr BitArray& flip()
+        {
+            flip_words(word_indices());
+            return *this;
+        }
+
+        constexpr BitArray& set_range(std::size_t l, std::size_t r)
+        {
+            check_range(l, r);
+            range_words(l, r, detail::range_op::set, word_indices());
+            return *this;
+        }
+
+        constexpr BitArray& clear_range(std::size_t l, std::size_t r)
+        {
+            check_range(l, r);
+            range_words(l, r, detail::range_op::clear, word_indices());
+            return *this;
+        }
+
+        constexpr BitArray& flip_range(std::size_t l, std::size_t r)
+        {
+            check_range(l, r);
+            range_words(l, r, detail::range_op::flip, word_indices());
+            return *this;
+        }
+
+        constexpr std::size_t count() const
+        {
+            return count_words();
+        }
+
+        constexpr bool any() const
+        {
+            return any_words(word_indices());
+        }
+
+        constexpr bool none() const
+        {
+            return !any();
+        }
+
+        constexpr bool all() const
+        {
+            return all_words(word_indices());
+        }
+
+        // First set bit in [pos, N), or npos.
+        constexpr std::size_t find_next_one(std::size_t pos) const
+        {
+            return pos >= N ? npos : find_next_words<false>(pos, word_indices());
+        }
+
+        // First clear bit in [pos, N), or npos.
+        constexpr std::size_t find_next_zero(std::size_t pos) const
+        {
+            return pos >= N ? npos : find_next_words<true>(pos, word_indices());
+        }
+
+        // Last set bit in [0, pos), or npos.
+        constexpr std::size_t find_prev_one(std::size_t pos) const
+        {
+            return find_prev_words<false>(pos < N ? pos : N);
+        }
+
+        // Last clear bit in [0, pos), or npos.
+        constexpr std::size_t find_prev_zero(std::size_t pos) const
+        {
+            return find_prev_words<true>(pos < N ? pos : N);
+        }
+
+        constexpr std::size_t find_first_one() const
+        {
+            return find_next_one(0);
+        }
+
+        constexpr std::size_t find_first_zero() const
+        {
+            return find_next_zero(0);
+        }
+
+        constexpr std::size_t find_last_one() const
+        {
+            return find_prev_one(N);
+        }
+
+        constexpr std::size_t find_last_zero() const
+        {
+            return find_prev_zero(N);
+        }
+
+        constexpr BitArray& operator&=(const BitArray& other)
+        {
+            apply_words(other, [](BitType a, BitType b) { return a & b; }, word_indices());
+            return *this;
+        }
+
+        constexpr BitArray& operator|=(const BitArray& other)
+        {
+            apply_words(other, [](BitType a, BitType b) { return a | b; }, word_indices());
+            return *this;
+        }
+
+        constexpr BitArray& operator^=(const BitArray& other)
+        {
+            apply_words(other, [](BitType a, BitType b) { return a ^ b; }, word_indices());
+            return *this;
+        }
+
+        // Clears every bit that is set in `other` (this &= ~other).
+        constexpr BitArray& andnot(const BitArray& other)
+        {
+            apply_words(other, [](BitType a, BitType b) { return a & ~b; }, word_indices());
+            return *this;
+        }
+
+        friend constexpr BitArray operator&(BitArray a, const BitArray& b)
+        {
+            return a &= b;
+        }
+
+        friend constexpr BitArray operator|(BitArray a, const BitArray& b)
+        {
+            return a |= b;
+        }
+
+        friend constexpr BitArray operator^(BitArray a, const BitArray& b)
+        {
+            return a ^= b;
+        }
+
+        friend constexpr BitArray operator~(BitArray a)
+        {
+            return a.flip();
+        }
+
+        friend constexpr bool operator==(const BitArray& a, const BitArray& b)
+        {
+            return a.equal_words(b, word_indices());
+        }
+
+        friend constexpr bool operator!=(const BitArray& a, const BitArray& b)
+        {
+            return !(a == b);
+        }
+    };
+
+} // namespace bowen
+
+#endif
@@ -2,7 +2,9 @@
 #define BITVECTOR_H
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <initializer_list>
 #include <iterator>
@@ -12,6 +14,8 @@
 #include <immintrin.h>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <simde/x86/avx2.h>
 #include <simde/x86/avx512.h>
 namespace bowen
@@ -55,6 +59,966 @@ namespace bowen
     static constexpr int WORD_SHIFT = compute_shift(WORD_BITS);
     static_assert((1u << WORD_SHIFT) == WORD_BITS,
                   "WORD_BITS must be a power of two for fast indexing");
+
+    namespace detail
+    {
+        // Alignment guaranteed by an allocator.  MMAllocator hands out
+        // ALIGN_SIZE-aligned blocks, so kernels may use aligned vector loads.
+        template<typename Allocator>
+        struct allocator_alignment {
+            static constexpr std::size_t value = alignof(BitType);
+        };
+
+        template<typename T, unsigned int ALIGN_SIZE>
+        struct allocator_alignment<MMAllocator<T, ALIGN_SIZE>> {
+            static constexpr std::size_t value = ALIGN_SIZE;
+        };
+
+        // Mask selecting the valid bits of the last word of a `bits`-long vector.
+        inline BitType tail_mask(std::size_t bits) {
+            const unsigned int rem = bits & (WORD_BITS - 1);
+            return rem ? (static_cast<BitType>(1) << rem) - 1 : ~static_cast<BitType>(0);
+        }
+
+        template<std::size_t Align>
+        inline __m256i load256(const BitType *p) {
+            if constexpr (Align % 32 == 0)
+                return _mm256_load_si256(reinterpret_cast<const __m256i *>(p));
+            else
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        }
+
+        template<std::size_t Align>
+        inline void store256(BitType *p, __m256i v) {
+            if constexpr (Align % 32 == 0)
+                _mm256_store_si256(reinterpret_cast<__m256i *>(p), v);
+            else
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+        }
+
+#if defined(__AVX512F__)
+        template<std::size_t Align>
+        inline __m512i load512(const BitType *p) {
+            if constexpr (Align % 64 == 0)
+                return _mm512_load_si512(p);
+            else
+                return _mm512_loadu_si512(p);
+        }
+
+        template<std::size_t Align>
+        inline void store512(BitType *p, __m512i v) {
+            if constexpr (Align % 64 == 0)
+                _mm512_store_si512(p, v);
+            else
+                _mm512_storeu_si512(p, v);
+        }
+#endif
+
+        struct and_op {
+            static BitType apply(BitType a, BitType b) { return a & b; }
+            static __m256i apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#if defined(__AVX512F__)
+            static __m512i apply(__m512i a, __m512i b) { return _mm512_and_si512(a, b); }
+#endif
+        };
+
+        struct or_op {
+            static BitType apply(BitType a, BitType b) { return a | b; }
+            static __m256i apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#if defined(__AVX512F__)
+            static __m512i apply(__m512i a, __m512i b) { return _mm512_or_si512(a, b); }
+#endif
+        };
+
+        struct xor_op {
+            static BitType apply(BitType a, BitType b) { return a ^ b; }
+            static __m256i apply(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+#if defined(__AVX512F__)
+            static __m512i apply(__m512i a, __m512i b) { return _mm512_xor_si512(a, b); }
+#endif
+        };
+
+        // a & ~b
+        struct andnot_op {
+            static BitType apply(BitType a, BitType b) { return a & ~b; }
+            static __m256i apply(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#if defined(__AVX512F__)
+            static __m512i apply(__m512i a, __m512i b) { return _mm512_andnot_si512(b, a); }
+#endif
+        };
+
+        // dst[i] = Op(a[i], b[i]) for `words` words.  dst may alias a or b.
+        template<typename Op, std::size_t Align = alignof(BitType)>
+        inline void bitwise_kernel(BitType *dst, const BitType *a, const BitType *b, std::size_t words) {
+            std::size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i < (words & ~static_cast<std::size_t>(7)); i += 8) {
+                store512<Align>(dst + i, Op::apply(load512<Align>(a + i), load512<Align>(b + i)));
+            }
+#endif
+            for (; i < (words & ~static_cast<std::size_t>(3)); i += 4) {
+                store256<Align>(dst + i, Op::apply(load256<Align>(a + i), load256<Align>(b + i)));
+            }
+            for (; i < words; ++i) {
+                dst[i] = Op::apply(a[i], b[i]);
+            }
+        }
+
+        // dst[i] = ~src[i] for `words` words.  dst may alias src.
+        template<std::size_t Align = alignof(BitType)>
+        inline void flip_kernel(BitType *dst, const BitType *src, std::size_t words) {
+            std::size_t i = 0;
+#if defined(__AVX512F__)
+            const __m512i ones512 = _mm512_set1_epi64(-1);
+            for (; i < (words & ~static_cast<std::size_t>(7)); i += 8) {
+                store512<Align>(dst + i, _mm512_xor_si512(load512<Align>(src + i), ones512));
+            }
+#endif
+            const __m256i ones = _mm256_set1_epi64x(-1);
+            for (; i < (words & ~static_cast<std::size_t>(3)); i += 4) {
+                store256<Align>(dst + i, _mm256_xor_si256(load256<Align>(src + i), ones));
+            }
+            for (; i < words; ++i) {
+                dst[i] = ~src[i];
+            }
+        }
+
+        inline std::size_t popcount_word(BitType w) {
+            return static_cast<std::size_t>(_mm_popcnt_u64(w));
+        }
+
+        // Position of the k-th (0-based) set bit of w; w must have more than k
+        // set bits.
+        inline unsigned int select_in_word(BitType w, unsigned int k) {
+#if defined(__BMI2__)
+            return static_cast<unsigned int>(_tzcnt_u64(_pdep_u64(static_cast<BitType>(1) << k, w)));
+#else
+            for (; k; --k)
+                w &= w - 1;
+            return static_cast<unsigned int>(_tzcnt_u64(w));
+#endif
+        }
+
+        // Index of the most significant set bit of a non-zero w.
+        inline unsigned int highest_bit(BitType w) {
+#if defined(__LZCNT__)
+            return static_cast<unsigned int>(WORD_BITS - 1 - _lzcnt_u64(w));
+#else
+            return static_cast<unsigned int>(WORD_BITS - 1 - __builtin_clzll(w));
+#endif
+        }
+
+        // First word index in [from, words) that is not equal to the skip
+        // pattern (all zeros, or all ones when SkipOnes), or `words` if there
+        // is none.  Runs of skippable words are tested 512 or 256 bits at a
+        // time.
+        template<bool SkipOnes>
+        inline std::size_t find_word_forward(const BitType *d, std::size_t from, std::size_t words) {
+            const BitType skip = SkipOnes ? ~static_cast<BitType>(0) : 0;
+            std::size_t i = from;
+#if defined(__AVX512F__)
+            const __m512i skip512 = _mm512_set1_epi64(static_cast<long long>(skip));
+            for (; words - i >= 8; i += 8) {
+                const __mmask8 m = _mm512_cmpneq_epi64_mask(_mm512_loadu_si512(d + i), skip512);
+                if (m)
+                    return i + _tzcnt_u32(m);
+            }
+#endif
+            const __m256i ones = _mm256_set1_epi64x(-1);
+            for (; words - i >= 4; i += 4) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(d + i));
+                if (SkipOnes ? !_mm256_testc_si256(v, ones) : !_mm256_testz_si256(v, v))
+                    break;
+            }
+            for (; i < words; ++i) {
+                if (d[i] != skip)
+                    return i;
+            }
+            return words;
+        }
+
+        // Last word index in [0, from] that is not equal to the skip pattern,
+        // or npos (SIZE_MAX) if there is none.
+        template<bool SkipOnes>
+        inline std::size_t find_word_backward(const BitType *d, std::size_t from) {
+            const BitType skip = SkipOnes ? ~static_cast<BitType>(0) : 0;
+            std::size_t end = from + 1; // words [0, end) remain
+#if defined(__AVX512F__)
+            const __m512i skip512 = _mm512_set1_epi64(static_cast<long long>(skip));
+            for (; end >= 8; end -= 8) {
+                const __mmask8 m = _mm512_cmpneq_epi64_mask(_mm512_loadu_si512(d + end - 8), skip512);
+                if (m)
+                    return end - 8 + highest_bit(m);
+            }
+#endif
+            const __m256i ones = _mm256_set1_epi64x(-1);
+            for (; end >= 4; end -= 4) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(d + end - 4));
+                if (SkipOnes ? !_mm256_testc_si256(v, ones) : !_mm256_testz_si256(v, v))
+                    break;
+            }
+            for (; end > 0; --end) {
+                if (d[end - 1] != skip)
+                    return end - 1;
+            }
+            return static_cast<std::size_t>(-1);
+        }
+
+        // Writes bitbase + i for every set bit i of w to out, in increasing
+        // order, and returns how many were written.  With AVX-512 VBMI2 the
+        // bit offsets are compressed into bytes in one instruction and widened
+        // with masked stores, so nothing is written past the last position.
+        template<typename T>
+        inline std::size_t extract_word(BitType w, std::size_t bitbase, T *out) {
+            static_assert(sizeof(T) == 4 || sizeof(T) == 8, "positions are 32 or 64-bit");
+#if defined(__AVX512VBMI2__)
+            const std::size_t c = popcount_word(w);
+            const __m512i iota = _mm512_set_epi64(0x3f3e3d3c3b3a3938, 0x3736353433323130,
+                                                  0x2f2e2d2c2b2a2928, 0x2726252423222120,
+                                                  0x1f1e1d1c1b1a1918, 0x1716151413121110,
+                                                  0x0f0e0d0c0b0a0908, 0x0706050403020100);
+            const __m512i idx = _mm512_maskz_compress_epi8(w, iota);
+            const __m128i parts[4] = {_mm512_extracti32x4_epi32(idx, 0), _mm512_extracti32x4_epi32(idx, 1),
+                                      _mm512_extracti32x4_epi32(idx, 2), _mm512_extracti32x4_epi32(idx, 3)};
+            if constexpr (sizeof(T) == 4) {
+                const __m512i vbase = _mm512_set1_epi32(static_cast<int>(bitbase));
+                for (std::size_t j = 0; j < c; j += 16) {
+                    const __m512i v = _mm512_add_epi32(_mm512_cvtepu8_epi32(parts[j / 16]), vbase);
+                    const __mmask16 m = c - j >= 16 ? static_cast<__mmask16>(0xffff)
+                                                    : static_cast<__mmask16>((1u << (c - j)) - 1);
+                    _mm512_mask_storeu_epi32(out + j, m, v);
+                }
+            } else {
+                const __m512i vbase = _mm512_set1_epi64(static_cast<long long>(bitbase));
+                for (std::size_t j = 0; j < c; j += 8) {
+                    const __m128i part = (j & 8) ? _mm_srli_si128(parts[j / 16], 8) : parts[j / 16];
+                    const __m512i v = _mm512_add_epi64(_mm512_cvtepu8_epi64(part), vbase);
+                    const __mmask8 m = c - j >= 8 ? static_cast<__mmask8>(0xff)
+                                                  : static_cast<__mmask8>((1u << (c - j)) - 1);
+                    _mm512_mask_storeu_epi64(out + j, m, v);
+                }
+            }
+            return c;
+#else
+            std::size_t n = 0;
+            while (w) {
+                out[n++] = static_cast<T>(bitbase + _tzcnt_u64(w));
+                w = _blsr_u64(w);
+            }
+            return n;
+#endif
+        }
+
+        // dst = src << k over `words` words (towards higher bit indices), with
+        // zeros shifted in.  dst may alias src.  Whole-word shifts are a
+        // memmove; otherwise each output word is a funnel shift of two input
+        // words, done with vpshldvq or vpsllvq/vpsrlvq when available.  The
+        // words are produced from the top down so the in-place case never
+        // reads a word it has already written.
+        inline void shift_left_words(BitType *dst, const BitType *src, std::size_t words, std::size_t k) {
+            const std::size_t ws = k >> WORD_SHIFT;
+            const unsigned int bs = k & (WORD_BITS - 1);
+            if (ws >= words) {
+                std::memset(dst, 0, words * sizeof(BitType));
+                return;
+            }
+            if (bs == 0) {
+                std::memmove(dst + ws, src, (words - ws) * sizeof(BitType));
+            } else {
+                std::size_t i = words; // dst[i, words) is done
+#if defined(__AVX512VBMI2__)
+                const __m512i vbs512 = _mm512_set1_epi64(bs);
+                while (i >= ws + 9) {
+                    i -= 8;
+                    const __m512i hi = _mm512_loadu_si512(src + i - ws);
+                    const __m512i lo = _mm512_loadu_si512(src + i - ws - 1);
+                    _mm512_storeu_si512(dst + i, _mm512_shldv_epi64(hi, lo, vbs512));
+                }
+#endif
+                const __m256i vbs = _mm256_set1_epi64x(bs);
+                const __m256i vrs = _mm256_set1_epi64x(WORD_BITS - bs);
+                while (i >= ws + 5) {
+                    i -= 4;
+                    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i - ws));
+                    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i - ws - 1));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                                        _mm256_or_si256(_mm256_sllv_epi64(hi, vbs), _mm256_srlv_epi64(lo, vrs)));
+                }
+                while (i > ws + 1) {
+                    --i;
+                    dst[i] = (src[i - ws] << bs) | (src[i - ws - 1] >> (WORD_BITS - bs));
+                }
+                dst[ws] = src[0] << bs;
+            }
+            std::memset(dst, 0, ws * sizeof(BitType));
+        }
+
+        // dst = src >> k over `words` words (towards lower bit indices).  The
+        // last source word is read through last_mask so bits past the logical
+        // size never shift into range.  With Or the result is ORed into dst
+        // and the vacated top words are left alone instead of cleared.  dst
+        // may alias src when Or is false; words are produced bottom up.
+        template<bool Or = false>
+        inline void shift_right_words(BitType *dst, const BitType *src, std::size_t words, std::size_t k, BitType last_mask) {
+            const std::size_t ws = k >> WORD_SHIFT;
+            const unsigned int bs = k & (WORD_BITS - 1);
+            if (ws >= words) {
+                if (!Or)
+                    std::memset(dst, 0, words * sizeof(BitType));
+                return;
+            }
+            const std::size_t out_words = words - ws;
+            auto get = [&](std::size_t j) -> BitType {
+                return j + 1 < words ? src[j] : (j + 1 == words ? src[j] & last_mask : 0);
+            };
+            auto put = [&](std::size_t i, BitType v) {
+                if (Or)
+                    dst[i] |= v;
+                else
+                    dst[i] = v;
+            };
+            std::size_t i = 0;
+            if (bs == 0 && !Or) {
+                std::memmove(dst, src + ws, (out_words - 1) * sizeof(BitType));
+                i = out_words - 1;
+            } else if (bs != 0) {
+                // Vector blocks only read words strictly before the last one.
+#if defined(__AVX512VBMI2__)
+                const __m512i vbs512 = _mm512_set1_epi64(bs);
+                for (; i + ws + 10 <= words; i += 8) {
+                    const __m512i lo = _mm512_loadu_si512(src + i + ws);
+                    const __m512i hi = _mm512_loadu_si512(src + i + ws + 1);
+                    __m512i v = _mm512_shrdv_epi64(lo, hi, vbs512);
+                    if (Or)
+                        v = _mm512_or_si512(v, _mm512_loadu_si512(dst + i));
+                    _mm512_storeu_si512(dst + i, v);
+                }
+#endif
+                const __m256i vbs = _mm256_set1_epi64x(bs);
+                const __m256i vls = _mm256_set1_epi64x(WORD_BITS - bs);
+                for (; i + ws + 6 <= words; i += 4) {
+                    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + ws));
+                    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + ws + 1));
+                    __m256i v = _mm256_or_si256(_mm256_srlv_epi64(lo, vbs), _mm256_sllv_epi64(hi, vls));
+                    if (Or)
+                        v = _mm256_or_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i)));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+                }
+            }
+            for (; i < out_words; ++i) {
+                BitType v = get(i + ws) >> bs;
+                if (bs)
+                    v |= get(i + ws + 1) << (WORD_BITS - bs);
+                put(i, v);
+            }
+            if (!Or)
+                std::memset(dst + out_words, 0, ws * sizeof(BitType));
+        }
+
+        // Strides up to this many bits use the repeating-pattern path of
+        // stride_kernel.
+        constexpr std::size_t STRIDE_PATTERN_MAX = 128;
+
+        inline void apply_word(BitType &word, BitType bits, bool value) {
+            if (value)
+                word |= bits;
+            else
+                word &= ~bits;
+        }
+
+        // Sets (value) or clears bits start, start + stride, ...,
+        // start + (count - 1) * stride.
+        //
+        // Small strides: the comb repeats every lcm(stride, 64) bits, i.e.
+        // every stride / gcd(stride, 64) words.  The period is rounded up to
+        // a whole number of 256-bit vectors, built once on the stack and ORed
+        // (or AND-NOTed) into the interior words with vector stores; the
+        // first and last words are masked to [start, end].
+        // Large strides: one scalar read-modify-write per bit, unrolled by
+        // four with a software prefetch a few strides ahead.
+        inline void stride_kernel(BitType *d, std::size_t start, std::size_t stride, std::size_t count, bool value) {
+            if (count == 0)
+                return;
+            if (stride == 0)
+                count = 1;
+            const std::size_t end = start + (count - 1) * stride; // last bit touched
+            const std::size_t wf = start >> WORD_SHIFT;
+            const std::size_t wl = end >> WORD_SHIFT;
+            if (stride && stride <= STRIDE_PATTERN_MAX && wl - wf >= 8 * stride) {
+                std::size_t g = WORD_BITS;
+                for (std::size_t b = stride; b;) {
+                    const std::size_t t = g % b;
+                    g = b;
+                    b = t;
+                }
+                std::size_t period = stride / g; // words
+                while (period & 3)
+                    period += stride / g;
+
+                alignas(32) BitType pat[4 * STRIDE_PATTERN_MAX] = {};
+                for (std::size_t r = (start & (WORD_BITS - 1)) % stride; r < period * WORD_BITS; r += stride)
+                    pat[r >> WORD_SHIFT] |= static_cast<BitType>(1) << (r & (WORD_BITS - 1));
+
+                apply_word(d[wf], pat[0] & (~static_cast<BitType>(0) << (start & (WORD_BITS - 1))), value);
+                // Advance to a word index whose pattern offset is a multiple
+                // of four so every vector load from pat is aligned and in range.
+                std::size_t w = wf + 1;
+                std::size_t k = 1;
+                for (; k & 3; ++k, ++w)
+                    apply_word(d[w], pat[k], value);
+                if (k == period)
+                    k = 0;
+                if (value) {
+                    for (; w + 4 <= wl; w += 4) {
+                        const __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i *>(pat + k));
+                        const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(d + w));
+                        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + w), _mm256_or_si256(cur, bits));
+                        k += 4;
+                        if (k == period)
+                            k = 0;
+                    }
+                } else {
+                    for (; w + 4 <= wl; w += 4) {
+                        const __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i *>(pat + k));
+                        const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(d + w));
+                        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + w), _mm256_andnot_si256(bits, cur));
+                        k += 4;
+                        if (k == period)
+                            k = 0;
+                    }
+                }
+                for (; w < wl; ++w) {
+                    apply_word(d[w], pat[k], value);
+                    if (++k == period)
+                        k = 0;
+                }
+                const unsigned int last = end & (WORD_BITS - 1);
+                const BitType tail = last == WORD_BITS - 1 ? ~static_cast<BitType>(0)
+                                                           : (static_cast<BitType>(1) << (last + 1)) - 1;
+                apply_word(d[wl], pat[k] & tail, value);
+                return;
+            }
+
+            constexpr std::size_t PREFETCH_AHEAD = 8;
+            const bool prefetch = stride >= 8 * WORD_BITS;
+            std::size_t pos = start;
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                if (prefetch && count - i > PREFETCH_AHEAD)
+                    _mm_prefetch(reinterpret_cast<const char *>(d + ((pos + PREFETCH_AHEAD * stride) >> WORD_SHIFT)), _MM_HINT_T0);
+                apply_word(d[pos >> WORD_SHIFT], static_cast<BitType>(1) << (pos & (WORD_BITS - 1)), value);
+                pos += stride;
+                apply_word(d[pos >> WORD_SHIFT], static_cast<BitType>(1) << (pos & (WORD_BITS - 1)), value);
+                pos += stride;
+                apply_word(d[pos >> WORD_SHIFT], static_cast<BitType>(1) << (pos & (WORD_BITS - 1)), value);
+                pos += stride;
+                apply_word(d[pos >> WORD_SHIFT], static_cast<BitType>(1) << (pos & (WORD_BITS - 1)), value);
+                pos += stride;
+            }
+            for (; i < count; ++i, pos += stride)
+                apply_word(d[pos >> WORD_SHIFT], static_cast<BitType>(1) << (pos & (WORD_BITS - 1)), value);
+        }
+
+        // Packs n flag bytes into num_words(n) words: bit i is set when
+        // src[i] is non-zero, and the bits past n in the last word are zero.
+        // Each full word is one 64-byte compare into a mask register
+        // (AVX-512 BW) or two 32-byte compares and vpmovmskb.  The tail is
+        // a masked load with AVX-512 BW, else 8 bytes per pext.
+        inline void pack_bytes(BitType *dst, const uint8_t *src, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + WORD_BITS <= n; i += WORD_BITS) {
+#if defined(__AVX512BW__)
+                const __m512i v = _mm512_loadu_si512(src + i);
+                dst[i >> WORD_SHIFT] = _mm512_test_epi8_mask(v, v);
+#else
+                const __m256i zero = _mm256_setzero_si256();
+                const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 32));
+                const uint32_t zlo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero)));
+                const uint32_t zhi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero)));
+                dst[i >> WORD_SHIFT] = ~((static_cast<BitType>(zhi) << 32) | zlo);
+#endif
+            }
+            if (i == n)
+                return;
+#if defined(__AVX512BW__)
+            const __m512i v = _mm512_maskz_loadu_epi8((static_cast<BitType>(1) << (n - i)) - 1, src + i);
+            dst[i >> WORD_SHIFT] = _mm512_test_epi8_mask(v, v);
+#else
+            BitType w = 0;
+            std::size_t j = 0;
+#if defined(__BMI2__)
+            const uint64_t low7 = 0x7f7f7f7f7f7f7f7full;
+            for (; i + j + 8 <= n; j += 8) {
+                uint64_t x;
+                std::memcpy(&x, src + i + j, sizeof(x));
+                // The high bit of each byte becomes "byte is non-zero".
+                x = ((x & low7) + low7) | x;
+                w |= static_cast<BitType>(_pext_u64(x, ~low7)) << j;
+            }
+#endif
+            for (; i + j < n; ++j)
+                w |= static_cast<BitType>(src[i + j] != 0) << j;
+            dst[i >> WORD_SHIFT] = w;
+#endif
+        }
+
+        // The k bits (1 <= k <= 64) starting at bit pos, in the low bits of
+        // the result; the bits above k are unspecified.  Reads the next word
+        // only when the range crosses into it.
+        inline BitType read_bits(const BitType *src, std::size_t pos, std::size_t k) {
+            const std::size_t w = pos >> WORD_SHIFT;
+            const unsigned int off = pos & (WORD_BITS - 1);
+            BitType v = src[w] >> off;
+            if (off && off + k > WORD_BITS)
+                v |= src[w + 1] << (WORD_BITS - off);
+            return v;
+        }
+
+        // Expands the n bits starting at bit pos into one element each: 0/1
+        // bytes, or 0/-1 int32 lanes usable as blend masks.  A full word is
+        // one masked move per 64 bytes or 16 lanes with AVX-512 BW; with
+        // AVX2, 32 bytes come from one byte shuffle, and, compare, and 8
+        // lanes from one and-compare.  The tail is a masked store on
+        // AVX-512 BW, else pdep for bytes and a plain loop for lanes.
+        template<typename T>
+        inline void unpack_bits(const BitType *src, std::size_t pos, std::size_t n, T *out) {
+            static_assert(sizeof(T) == 1 || sizeof(T) == 4, "unpacks to bytes or 32-bit lanes");
+#if defined(__AVX512BW__)
+            const __m512i ones = sizeof(T) == 1 ? _mm512_set1_epi8(1) : _mm512_set1_epi32(-1);
+            std::size_t i = 0;
+            for (; i < n; i += WORD_BITS) {
+                const std::size_t k = std::min<std::size_t>(WORD_BITS, n - i);
+                BitType w = read_bits(src, pos + i, k);
+                if constexpr (sizeof(T) == 1) {
+                    const __mmask64 live = k == WORD_BITS ? ~__mmask64(0) : (__mmask64(1) << k) - 1;
+                    _mm512_mask_storeu_epi8(out + i, live, _mm512_maskz_mov_epi8(w, ones));
+                } else {
+                    for (std::size_t j = 0; j < k; j += 16, w >>= 16) {
+                        const __mmask16 live = k - j >= 16 ? __mmask16(0xffff) : __mmask16((1u << (k - j)) - 1);
+                        _mm512_mask_storeu_epi32(out + i + j, live, _mm512_maskz_mov_epi32(__mmask16(w), ones));
+                    }
+                }
+            }
+#else
+            const __m256i byte_of_bit = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                         2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+            const __m256i byte_bit = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+            const __m256i lane_bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+            std::size_t i = 0;
+            for (; i + WORD_BITS <= n; i += WORD_BITS) {
+                const BitType w = read_bits(src, pos + i, WORD_BITS);
+                if constexpr (sizeof(T) == 1) {
+                    for (unsigned int j = 0; j < WORD_BITS; j += 32) {
+                        __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(w >> j)), byte_of_bit);
+                        v = _mm256_cmpeq_epi8(_mm256_and_si256(v, byte_bit), byte_bit);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + j), _mm256_and_si256(v, _mm256_set1_epi8(1)));
+                    }
+                } else {
+                    for (unsigned int j = 0; j < WORD_BITS; j += 8) {
+                        const __m256i v = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>((w >> j) & 0xff)), lane_bit);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + j), _mm256_cmpeq_epi32(v, lane_bit));
+                    }
+                }
+            }
+            if (i == n)
+                return;
+            const T one = sizeof(T) == 1 ? T(1) : T(-1);
+            BitType w = read_bits(src, pos + i, n - i);
+            std::size_t j = 0;
+#if defined(__BMI2__)
+            if constexpr (sizeof(T) == 1) {
+                for (; j + 8 <= n - i; j += 8, w >>= 8) {
+                    const uint64_t bytes = _pdep_u64(w, 0x0101010101010101ull);
+                    std::memcpy(out + i + j, &bytes, sizeof(bytes));
+                }
+            }
+#endif
+            for (; i + j < n; ++j, w >>= 1)
+                out[i + j] = (w & 1) ? one : T(0);
+#endif
+        }
+
+        // Word sources feed the popcount kernels.  A source yields either the
+        // stored words or Op(a, b) computed on the fly, so fused counts never
+        // materialise an intermediate vector.
+        template<std::size_t Align = alignof(BitType)>
+        struct word_source {
+            const BitType *a;
+            BitType word(std::size_t i) const { return a[i]; }
+            __m256i vec256(std::size_t i) const { return load256<Align>(a + i); }
+#if defined(__AVX512F__)
+            __m512i vec512(std::size_t i) const { return load512<Align>(a + i); }
+#endif
+        };
+
+        template<typename Op, std::size_t Align = alignof(BitType)>
+        struct binary_source {
+            const BitType *a;
+            const BitType *b;
+            BitType word(std::size_t i) const { return Op::apply(a[i], b[i]); }
+            __m256i vec256(std::size_t i) const { return Op::apply(load256<Align>(a + i), load256<Align>(b + i)); }
+#if defined(__AVX512F__)
+            __m512i vec512(std::size_t i) const { return Op::apply(load512<Align>(a + i), load512<Align>(b + i)); }
+#endif
+        };
+
+#if defined(__AVX2__)
+        // Per-64-bit-lane popcount via the nibble lookup (Mula).
+        inline __m256i popcount256(__m256i v) {
+            const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low_mask = _mm256_set1_epi8(0x0f);
+            const __m256i lo = _mm256_and_si256(v, low_mask);
+            const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+            const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                                _mm256_shuffle_epi8(lookup, hi));
+            return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+        }
+
+        inline std::size_t hsum256(__m256i v) {
+            return static_cast<std::size_t>(_mm256_extract_epi64(v, 0)) +
+                   static_cast<std::size_t>(_mm256_extract_epi64(v, 1)) +
+                   static_cast<std::size_t>(_mm256_extract_epi64(v, 2)) +
+                   static_cast<std::size_t>(_mm256_extract_epi64(v, 3));
+        }
+
+        // Carry-save adder: h:l = a + b + c, bitwise.
+        inline void csa256(__m256i &h, __m256i &l, __m256i a, __m256i b, __m256i c) {
+            const __m256i u = _mm256_xor_si256(a, b);
+            h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+            l = _mm256_xor_si256(u, c);
+        }
+
+        // Harley-Seal popcount over `blocks` blocks of 16 vectors (64 words).
+        template<typename Source>
+        inline std::size_t harley_seal256(const Source &src, std::size_t blocks) {
+            __m256i total = _mm256_setzero_si256();
+            __m256i ones = _mm256_setzero_si256();
+            __m256i twos = _mm256_setzero_si256();
+            __m256i fours = _mm256_setzero_si256();
+            __m256i eights = _mm256_setzero_si256();
+            __m256i sixteens, twosA, twosB, foursA, foursB, eightsA, eightsB;
+            for (std::size_t blk = 0; blk < blocks; ++blk) {
+                const std::size_t w = blk * 64;
+                csa256(twosA, ones, ones, src.vec256(w + 0), src.vec256(w + 4));
+                csa256(twosB, ones, ones, src.vec256(w + 8), src.vec256(w + 12));
+                csa256(foursA, twos, twos, twosA, twosB);
+                csa256(twosA, ones, ones, src.vec256(w + 16), src.vec256(w + 20));
+                csa256(twosB, ones, ones, src.vec256(w + 24), src.vec256(w + 28));
+                csa256(foursB, twos, twos, twosA, twosB);
+                csa256(eightsA, fours, fours, foursA, foursB);
+                csa256(twosA, ones, ones, src.vec256(w + 32), src.vec256(w + 36));
+                csa256(twosB, ones, ones, src.vec256(w + 40), src.vec256(w + 44));
+                csa256(foursA, twos, twos, twosA, twosB);
+                csa256(twosA, ones, ones, src.vec256(w + 48), src.vec256(w + 52));
+                csa256(twosB, ones, ones, src.vec256(w + 56), src.vec256(w + 60));
+                csa256(foursB, twos, twos, twosA, twosB);
+                csa256(eightsB, fours, fours, foursA, foursB);
+                csa256(sixteens, eights, eights, eightsA, eightsB);
+                total = _mm256_add_epi64(total, popcount256(sixteens));
+            }
+            total = _mm256_slli_epi64(total, 4);
+            total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(eights), 3));
+            total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(fours), 2));
+            total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(twos), 1));
+            total = _mm256_add_epi64(total, popcount256(ones));
+            return hsum256(total);
+        }
+#endif
+
+        // Number of set bits in the first `words` words produced by `src`.
+        template<typename Source>
+        inline std::size_t popcount_kernel(const Source &src, std::size_t words) {
+            std::size_t i = 0;
+            std::size_t total = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+            __m512i acc = _mm512_setzero_si512();
+            for (; i < (words & ~static_cast<std::size_t>(7)); i += 8) {
+                acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(src.vec512(i)));
+            }
+            total += static_cast<std::size_t>(_mm512_reduce_add_epi64(acc));
+#elif defined(__AVX2__)
+            const std::size_t blocks = words / 64;
+            total += harley_seal256(src, blocks);
+            i = blocks * 64;
+            for (; i < (words & ~static_cast<std::size_t>(3)); i += 4) {
+                total += hsum256(popcount256(src.vec256(i)));
+            }
+#endif
+            for (; i < words; ++i) {
+                total += popcount_word(src.word(i));
+            }
+            return total;
+        }
+
+        // True if any of the first `words` words produced by `src` is non-zero.
+        template<typename Source>
+        inline bool any_kernel(const Source &src, std::size_t words) {
+            std::size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i < (words & ~static_cast<std::size_t>(7)); i += 8) {
+                const __m512i v = src.vec512(i);
+                if (_mm512_test_epi64_mask(v, v))
+                    return true;
+            }
+#endif
+            for (; i < (words & ~static_cast<std::size_t>(3)); i += 4) {
+                const __m256i v = src.vec256(i);
+                if (!_mm256_testz_si256(v, v))
+                    return true;
+            }
+            for (; i < words; ++i) {
+                if (src.word(i))
+                    return true;
+            }
+            return false;
+        }
+
+        // dst[i] = src.word(i) for `words` words, one vector at a time.
+        template<std::size_t Align, typename Source>
+        inline void eval_kernel(BitType *dst, const Source &src, std::size_t words) {
+            std::size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i < (words & ~static_cast<std::size_t>(7)); i += 8) {
+                store512<Align>(dst + i, src.vec512(i));
+            }
+#endif
+            for (; i < (words & ~static_cast<std::size_t>(3)); i += 4) {
+                store256<Align>(dst + i, src.vec256(i));
+            }
+            for (; i < words; ++i) {
+                dst[i] = src.word(i);
+            }
+        }
+
+        // Helpers on raw words for the bit range [l, r) of the words at d.
+        // BitVector passes its whole size, spans their offset range.
+
+        enum class range_op { set, clear, flip };
+
+        inline void apply_mask(BitType &word, BitType mask, range_op op) {
+            if (op == range_op::set)
+                word |= mask;
+            else if (op == range_op::clear)
+                word &= ~mask;
+            else
+                word ^= mask;
+        }
+
+        // Applies op to [l, r): masked read-modify-write on the partial head
+        // and tail words, memset or a SIMD flip on the whole words between.
+        inline void modify_bits(BitType *d, std::size_t l, std::size_t r, range_op op) {
+            if (l >= r)
+                return;
+            const std::size_t wl = l >> WORD_SHIFT;
+            const std::size_t wr = r >> WORD_SHIFT;
+            const BitType head = ~static_cast<BitType>(0) << (l & (WORD_BITS - 1));
+            const BitType tail = (static_cast<BitType>(1) << (r & (WORD_BITS - 1))) - 1;
+            if (wl == wr) {
+                apply_mask(d[wl], head & tail, op);
+                return;
+            }
+            apply_mask(d[wl], head, op);
+            const std::size_t interior = wr - wl - 1;
+            if (op == range_op::set)
+                std::memset(d + wl + 1, 0xff, interior * sizeof(BitType));
+            else if (op == range_op::clear)
+                std::memset(d + wl + 1, 0, interior * sizeof(BitType));
+            else
+                flip_kernel(d + wl + 1, d + wl + 1, interior);
+            if (tail)
+                apply_mask(d[wr], tail, op);
+        }
+
+        // True if any bit of [l, r) differs from the skip value (0 for any(),
+        // 1 for the complement of all()).
+        template<bool SkipOnes>
+        inline bool range_has_other(const BitType *d, std::size_t l, std::size_t r) {
+            if (l >= r)
+                return false;
+            const BitType invert = SkipOnes ? ~static_cast<BitType>(0) : 0;
+            const std::size_t wl = l >> WORD_SHIFT;
+            const std::size_t wr = r >> WORD_SHIFT;
+            const BitType head = ~static_cast<BitType>(0) << (l & (WORD_BITS - 1));
+            const BitType tail = (static_cast<BitType>(1) << (r & (WORD_BITS - 1))) - 1;
+            if (wl == wr)
+                return ((d[wl] ^ invert) & head & tail) != 0;
+            if ((d[wl] ^ invert) & head)
+                return true;
+            if (find_word_forward<SkipOnes>(d, wl + 1, wr) != wr)
+                return true;
+            return tail && ((d[wr] ^ invert) & tail) != 0;
+        }
+
+        // Number of set bits in [l, r).
+        inline std::size_t count_bits(const BitType *d, std::size_t l, std::size_t r) {
+            if (l >= r)
+                return 0;
+            const std::size_t wl = l >> WORD_SHIFT;
+            const std::size_t wr = r >> WORD_SHIFT;
+            const BitType head = ~static_cast<BitType>(0) << (l & (WORD_BITS - 1));
+            const BitType tail = (static_cast<BitType>(1) << (r & (WORD_BITS - 1))) - 1;
+            if (wl == wr)
+                return popcount_word(d[wl] & head & tail);
+            std::size_t total = popcount_word(d[wl] & head);
+            total += popcount_kernel(word_source<>{d + wl + 1}, wr - wl - 1);
+            if (tail)
+                total += popcount_word(d[wr] & tail);
+            return total;
+        }
+
+        // First set (or, with Zero, clear) bit in [pos, end), or npos.
+        // Zero searches look for set bits in the inverted words.
+        template<bool Zero>
+        inline std::size_t find_next_bit(const BitType *d, std::size_t pos, std::size_t end) {
+            const std::size_t npos = static_cast<std::size_t>(-1);
+            if (pos >= end)
+                return npos;
+            const BitType invert = Zero ? ~static_cast<BitType>(0) : 0;
+            std::size_t w = pos >> WORD_SHIFT;
+            BitType word = (d[w] ^ invert) & (~static_cast<BitType>(0) << (pos & (WORD_BITS - 1)));
+            if (!word) {
+                const std::size_t words = (end + WORD_BITS - 1) / WORD_BITS;
+                w = find_word_forward<Zero>(d, w + 1, words);
+                if (w == words)
+                    return npos;
+                word = d[w] ^ invert;
+            }
+            const std::size_t found = (w << WORD_SHIFT) + _tzcnt_u64(word);
+            return found < end ? found : npos;
+        }
+
+        // Last set (or clear) bit in [begin, pos), or npos.
+        template<bool Zero>
+        inline std::size_t find_prev_bit(const BitType *d, std::size_t begin, std::size_t pos) {
+            const std::size_t npos = static_cast<std::size_t>(-1);
+            if (pos <= begin)
+                return npos;
+            const BitType invert = Zero ? ~static_cast<BitType>(0) : 0;
+            const std::size_t wb = begin >> WORD_SHIFT;
+            const std::size_t last = pos - 1;
+            std::size_t w = last >> WORD_SHIFT;
+            BitType word = (d[w] ^ invert) & (~static_cast<BitType>(0) >> (WORD_BITS - 1 - (last & (WORD_BITS - 1))));
+            if (!word) {
+                if (w == wb)
+                    return npos;
+                w = find_word_backward<Zero>(d + wb, w - 1 - wb);
+                if (w == npos)
+                    return npos;
+                w += wb;
+                word = d[w] ^ invert;
+            }
+            const std::size_t found = (w << WORD_SHIFT) + highest_bit(word);
+            return found >= begin ? found : npos;
+        }
+
+        // Writes base + i for at most `capacity` set bits i in [pos, end)
+        // and moves `pos` to the first bit that was not reported.
+        template<typename T>
+        inline std::size_t extract_ones_bits(const BitType *d, std::size_t end, T *out, std::size_t capacity,
+                                             std::size_t &pos, std::size_t base) {
+            if (pos >= end) {
+                pos = end;
+                return 0;
+            }
+            const std::size_t words = (end + WORD_BITS - 1) / WORD_BITS;
+            std::size_t written = 0;
+            std::size_t w = pos >> WORD_SHIFT;
+            BitType word = d[w] & (~static_cast<BitType>(0) << (pos & (WORD_BITS - 1)));
+            for (;;) {
+                if (w + 1 == words)
+                    word &= tail_mask(end);
+                if (word) {
+                    const std::size_t room = capacity - written;
+                    if (popcount_word(word) > room) {
+                        const unsigned int stop = select_in_word(word, static_cast<unsigned int>(room));
+                        word &= (static_cast<BitType>(1) << stop) - 1;
+                        extract_word(word, base + (w << WORD_SHIFT), out + written);
+                        pos = (w << WORD_SHIFT) + stop;
+                        return capacity;
+                    }
+                    written += extract_word(word, base + (w << WORD_SHIFT), out + written);
+                }
+                w = find_word_forward<false>(d, w + 1, words);
+                if (w == words)
+                    break;
+                word = d[w];
+            }
+            pos = end;
+            return written;
+        }
+
+        // Base of every lazy expression node; used to constrain the operators.
+        struct bit_expr_tag {};
+
+        template<typename T>
+        struct is_bit_expr : std::is_base_of<bit_expr_tag, T> {};
+
+        // Base of the execution policies taken by the parallel overloads
+        // (see parallel.hpp).  A policy provides
+        //   for_each(base, words, fn)             calls fn(begin, end) per chunk
+        //   reduce(base, words, init, fn, combine)
+        // and places every chunk boundary on a CACHE_LINE_BYTES-aligned
+        // address, so no two threads ever write the same word or line.
+        struct execution_policy_tag {};
+
+        template<typename T>
+        struct is_execution_policy : std::is_base_of<execution_policy_tag, T> {};
+
+        constexpr std::size_t CACHE_LINE_BYTES = 64;
+
+        // Allocators that can grow a block without copying it (mremap, for
+        // example) provide reallocate(p, old_n, new_n); reserve() uses it.
+        template<typename Allocator, typename = void>
+        struct has_reallocate : std::false_type {};
+
+        template<typename Allocator>
+        struct has_reallocate<Allocator, std::void_t<decltype(std::declval<Allocator&>().reallocate(
+            std::declval<BitType*>(), std::size_t(), std::size_t()))>> : std::true_type {};
+
+        // Stateless allocators such as MMAllocator need not define ==.
+        template<typename Allocator>
+        bool allocators_equal(const Allocator& a, const Allocator& b)
+        {
+            if constexpr (std::allocator_traits<Allocator>::is_always_equal::value)
+                return true;
+            else
+                return a == b;
+        }
+
+        // Words a BitVector keeps inside the object before it spills to the
+        // allocator.  The empty specialisation adds no bytes to the default
+        // BitVector, which derives from it.
+        template<std::size_t Words, std::size_t Align>
+        class inline_storage {
+        protected:
+            BitType* inline_data() { return m_inline; }
+            const BitType* inline_data() const { return m_inline; }
+
+        private:
+            alignas(Align) BitType m_inline[Words];
+        };
+
+        template<std::size_t Align>
+        class inline_storage<0, Align> {
+        protected:
+            BitType* inline_data() { return nullptr; }
+            const BitType* inline_data() const { return nullptr; }
+        };
+    } // namespace detail
+
+    // Selects the BitVector constructor that takes over the words the
+    // allocator already holds (a mapped file, for instance) instead of
+    // filling fresh storage.
+    struct adopt_storage_t {
+        explicit adopt_storage_t() = default;
+    };
+    constexpr adopt_storage_t adopt_storage{};
+
+    class ConstBitSpan;
+    class BitSpan;
+
     template<typename Allocator = std::allocator<BitType>>
     class BitReference
     {
@@ -68,357 +1032,1992 @@ namespace bowen
 
         operator bool() const
         {
-            return (*m_ptr & m_mask) != 0;
+            return (*m_ptr & m_mask) != 0;
+        }
+
+        BitReference& operator=(bool value)
+        {
+            if (value)
+                *m_ptr |= m_mask;
+            else
+                *m_ptr &= ~m_mask;
+            return *this;
+        }
+
+        BitReference& operator=(const BitReference& ref)
+        {
+            return *this = static_cast<bool>(ref);
+        }
+
+        void flip()
+        {
+            *m_ptr ^= m_mask;
+        }
+    };
+
+    namespace detail
+    {
+        // Position of a bit as a word pointer plus the bit's index in that
+        // word; the state shared by the mutable and const bit iterators.
+        // Comparisons and differences work across the two kinds.
+        class bit_iterator_base {
+        public:
+            BitType* m_ptr;
+            unsigned int m_offset;
+
+            bit_iterator_base(BitType* ptr, unsigned int offset)
+                : m_ptr(ptr), m_offset(offset) {}
+
+            void bump_up() {
+                if (++m_offset == WORD_BITS) {
+                    m_offset = 0;
+                    ++m_ptr;
+                }
+            }
+
+            void bump_down() {
+                if (m_offset-- == 0) {
+                    m_offset = WORD_BITS - 1;
+                    --m_ptr;
+                }
+            }
+
+            void advance(std::ptrdiff_t n) {
+                std::ptrdiff_t bit = n + static_cast<std::ptrdiff_t>(m_offset);
+                std::ptrdiff_t words = bit / WORD_BITS;
+                bit %= WORD_BITS;
+                if (bit < 0) {
+                    bit += WORD_BITS;
+                    --words;
+                }
+                m_ptr += words;
+                m_offset = static_cast<unsigned int>(bit);
+            }
+
+            friend bool operator==(const bit_iterator_base& a, const bit_iterator_base& b) {
+                return a.m_ptr == b.m_ptr && a.m_offset == b.m_offset;
+            }
+
+            friend bool operator!=(const bit_iterator_base& a, const bit_iterator_base& b) {
+                return !(a == b);
+            }
+
+            friend bool operator<(const bit_iterator_base& a, const bit_iterator_base& b) {
+                return a.m_ptr < b.m_ptr || (a.m_ptr == b.m_ptr && a.m_offset < b.m_offset);
+            }
+
+            friend bool operator>(const bit_iterator_base& a, const bit_iterator_base& b) {
+                return b < a;
+            }
+
+            friend bool operator<=(const bit_iterator_base& a, const bit_iterator_base& b) {
+                return !(b < a);
+            }
+
+            friend bool operator>=(const bit_iterator_base& a, const bit_iterator_base& b) {
+                return !(a < b);
+            }
+
+            friend std::ptrdiff_t operator-(const bit_iterator_base& a, const bit_iterator_base& b) {
+                return WORD_BITS * (a.m_ptr - b.m_ptr) + static_cast<std::ptrdiff_t>(a.m_offset) -
+                       static_cast<std::ptrdiff_t>(b.m_offset);
+            }
+        };
+    } // namespace detail
+
+    // Random-access iterator over the bits of a BitVector.  The bit
+    // algorithms at the end of this header (count, find, fill, copy, equal)
+    // take whole words or SIMD registers at a time on these iterators.
+    template<typename Allocator = std::allocator<BitType>>
+    class BitIterator : public detail::bit_iterator_base {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = bool;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void; // Not applicable for bit iterators
+        using reference = BitReference<Allocator>;
+
+        BitIterator(BitType* ptr = nullptr, unsigned int offset = 0)
+            : bit_iterator_base(ptr, offset) {}
+
+        reference operator*() const {
+            return BitReference<Allocator>(m_ptr, static_cast<BitType>(1) << m_offset);
+        }
+
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+
+        BitIterator& operator++() {
+            bump_up();
+            return *this;
+        }
+
+        BitIterator operator++(int) {
+            BitIterator tmp = *this;
+            bump_up();
+            return tmp;
+        }
+
+        BitIterator& operator--() {
+            bump_down();
+            return *this;
+        }
+
+        BitIterator operator--(int) {
+            BitIterator tmp = *this;
+            bump_down();
+            return tmp;
+        }
+
+        BitIterator& operator+=(difference_type n) {
+            advance(n);
+            return *this;
+        }
+
+        BitIterator& operator-=(difference_type n) {
+            advance(-n);
+            return *this;
+        }
+
+        friend BitIterator operator+(BitIterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend BitIterator operator+(difference_type n, BitIterator it) {
+            return it += n;
+        }
+
+        friend BitIterator operator-(BitIterator it, difference_type n) {
+            return it -= n;
+        }
+    };
+
+    template<typename Allocator = std::allocator<BitType>>
+    class BitConstIterator : public detail::bit_iterator_base {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = bool;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = bool;
+
+        BitConstIterator(const BitType* ptr = nullptr, unsigned int offset = 0)
+            : bit_iterator_base(const_cast<BitType*>(ptr), offset) {}
+
+        BitConstIterator(const BitIterator<Allocator>& it)
+            : bit_iterator_base(it.m_ptr, it.m_offset) {}
+
+        reference operator*() const {
+            return (*m_ptr >> m_offset) & 1;
+        }
+
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+
+        BitConstIterator& operator++() {
+            bump_up();
+            return *this;
+        }
+
+        BitConstIterator operator++(int) {
+            BitConstIterator tmp = *this;
+            bump_up();
+            return tmp;
+        }
+
+        BitConstIterator& operator--() {
+            bump_down();
+            return *this;
+        }
+
+        BitConstIterator operator--(int) {
+            BitConstIterator tmp = *this;
+            bump_down();
+            return tmp;
+        }
+
+        BitConstIterator& operator+=(difference_type n) {
+            advance(n);
+            return *this;
+        }
+
+        BitConstIterator& operator-=(difference_type n) {
+            advance(-n);
+            return *this;
+        }
+
+        friend BitConstIterator operator+(BitConstIterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend BitConstIterator operator+(difference_type n, BitConstIterator it) {
+            return it += n;
+        }
+
+        friend BitConstIterator operator-(BitConstIterator it, difference_type n) {
+            return it -= n;
+        }
+    };
+
+    // With InlineBits > 0 the vector keeps up to InlineBits bits inside the
+    // object and only calls the allocator once it grows past them, so short
+    // vectors cost no allocation and no pointer chase to a separate block.
+    // SmallBitVector<N> names that form.
+    template<typename Allocator = std::allocator<BitType>, std::size_t InlineBits = 0>
+    class BitVector
+        : private detail::inline_storage<(InlineBits + WORD_BITS - 1) / WORD_BITS,
+                                         detail::allocator_alignment<Allocator>::value>
+    {
+    private:
+        typedef std::allocator_traits<Allocator> alloc_traits;
+
+        static constexpr std::size_t INLINE_WORDS = (InlineBits + WORD_BITS - 1) / WORD_BITS;
+
+        BitType* m_data;
+        size_t m_size;
+        size_t m_capacity;
+        Allocator m_allocator;
+
+        bool is_inline() const {
+            return INLINE_WORDS && m_data == this->inline_data();
+        }
+
+        // Points m_data at room for word_count words: the inline words when
+        // they are enough, a new block from the allocator otherwise.
+        void allocate_memory(size_t word_count) {
+            if (INLINE_WORDS && word_count <= INLINE_WORDS) {
+                m_data = this->inline_data();
+                m_capacity = INLINE_WORDS;
+            } else {
+                m_data = m_allocator.allocate(word_count);
+                m_capacity = word_count;
+            }
+        }
+
+        void deallocate_memory() {
+            if (m_data && !is_inline()) {
+                m_allocator.deallocate(m_data, m_capacity);
+            }
+        }
+
+        // Frees the storage and leaves the vector without any.
+        void release() {
+            deallocate_memory();
+            m_data = nullptr;
+            m_capacity = 0;
+        }
+
+        // Makes room for `extra` more bits, at least doubling the capacity
+        // like push_back so repeated appends stay amortised O(1) per word.
+        void grow_for_append(size_t extra)
+        {
+            if (m_size + extra > m_capacity * WORD_BITS)
+                reserve(std::max(m_size + extra, m_capacity * WORD_BITS * 2));
+        }
+
+        static size_t num_words(size_t bits)
+        {
+            return (bits + WORD_BITS - 1) / WORD_BITS;
+        }
+
+        static constexpr std::size_t ALIGN = detail::allocator_alignment<Allocator>::value;
+
+        void check_same_size(const BitVector& other) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (m_size != other.m_size){
+                std::stringstream  ss;
+                ss << "BitVector size mismatch" << " lhs: " << m_size << " rhs: " << other.m_size << std::endl;
+                throw std::invalid_argument(ss.str());
+            }
+#else
+            (void)other;
+#endif
+        }
+
+        void check_range(size_t l, size_t r) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (l > r || r > m_size){
+                std::stringstream  ss;
+                ss << "BitVector range out of range" << " l: " << l << " r: " << r << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#else
+            (void)l;
+            (void)r;
+#endif
+        }
+
+        void modify_range(size_t l, size_t r, detail::range_op op)
+        {
+            check_range(l, r);
+            detail::modify_bits(m_data, l, r, op);
+        }
+
+        template<bool SkipOnes>
+        bool range_has_other(size_t l, size_t r) const
+        {
+            check_range(l, r);
+            return detail::range_has_other<SkipOnes>(m_data, l, r);
+        }
+
+        struct uninitialized_tag {};
+
+        // Allocates storage for n bits without filling it; callers overwrite
+        // every word straight away.
+        BitVector(size_t n, uninitialized_tag)
+            : m_size(n)
+        {
+            allocate_memory(num_words(n));
+        }
+
+        BitVector(size_t n, uninitialized_tag, const Allocator& alloc)
+            : m_size(n), m_allocator(alloc)
+        {
+            allocate_memory(num_words(n));
+        }
+
+        template<bool Zero>
+        size_t find_next(size_t pos) const
+        {
+            return detail::find_next_bit<Zero>(m_data, pos, m_size);
+        }
+
+        template<bool Zero>
+        size_t find_prev(size_t pos) const
+        {
+            return detail::find_prev_bit<Zero>(m_data, 0, std::min(pos, m_size));
+        }
+
+        template<typename T>
+        size_t extract_ones_impl(T* out, size_t capacity, size_t& pos, size_t base) const
+        {
+            return detail::extract_ones_bits(m_data, m_size, out, capacity, pos, base);
+        }
+
+        // Alignment of every chunk start handed out by an execution policy.
+        static constexpr std::size_t CHUNK_ALIGN = ALIGN < detail::CACHE_LINE_BYTES ? ALIGN : detail::CACHE_LINE_BYTES;
+
+        template<typename Op, typename Policy>
+        BitVector& parallel_bitwise(const Policy& policy, const BitVector& other)
+        {
+            check_same_size(other);
+            BitType* dst = m_data;
+            const BitType* src = other.m_data;
+            policy.for_each(dst, num_words(m_size), [dst, src](size_t b, size_t e) {
+                detail::bitwise_kernel<Op, CHUNK_ALIGN>(dst + b, dst + b, src + b, e - b);
+            });
+            return *this;
+        }
+
+        // Each chunk scans its own words unless an earlier chunk has already
+        // found a match; the lowest matching word wins.
+        template<bool Zero, typename Policy>
+        size_t parallel_find_first(const Policy& policy) const
+        {
+            const size_t words = num_words(m_size);
+            const BitType* data = m_data;
+            std::atomic<size_t> first(words);
+            policy.for_each(data, words, [data, &first](size_t b, size_t e) {
+                if (b >= first.load(std::memory_order_relaxed))
+                    return;
+                const size_t w = detail::find_word_forward<Zero>(data, b, e);
+                if (w == e)
+                    return;
+                size_t current = first.load(std::memory_order_relaxed);
+                while (w < current && !first.compare_exchange_weak(current, w, std::memory_order_relaxed)) {
+                }
+            });
+            const size_t w = first.load();
+            if (w == words)
+                return npos;
+            const BitType invert = Zero ? ~static_cast<BitType>(0) : 0;
+            const size_t found = (w << WORD_SHIFT) + _tzcnt_u64(m_data[w] ^ invert);
+            return found < m_size ? found : npos;
+        }
+
+        template<typename Op>
+        static size_t fused_count(const BitVector& a, const BitVector& b)
+        {
+            a.check_same_size(b);
+            const size_t full = a.m_size >> WORD_SHIFT;
+            size_t total = detail::popcount_kernel(detail::binary_source<Op, ALIGN>{a.m_data, b.m_data}, full);
+            if (a.m_size & (WORD_BITS - 1))
+                total += detail::popcount_word(Op::apply(a.m_data[full], b.m_data[full]) & detail::tail_mask(a.m_size));
+            return total;
+        }
+
+    public:
+        typedef BitIterator<Allocator> iterator;
+        typedef BitConstIterator<Allocator> const_iterator;
+        typedef bool value_type;
+        typedef size_t size_type;
+        typedef BitReference<Allocator> reference;
+
+        // Returned by the find_* family when no matching bit exists.
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        BitVector()
+            : m_data(nullptr), m_size(0), m_capacity(0) {}
+
+        explicit BitVector(size_t n, bool value = false)
+            : m_size(n)
+        {
+            allocate_memory(num_words(n));
+            std::memset(m_data, value ? ~0 : 0, m_capacity * sizeof(BitType));
+        }
+
+        BitVector(size_t n, bool value, const Allocator& alloc)
+            : m_size(n), m_allocator(alloc)
+        {
+            allocate_memory(num_words(n));
+            std::memset(m_data, value ? ~0 : 0, m_capacity * sizeof(BitType));
+        }
+
+        // Uses the first num_words(n) words returned by
+        // alloc.allocate(num_words(n)) as they are, even when they would fit
+        // inline.
+        BitVector(size_t n, const Allocator& alloc, adopt_storage_t)
+            : m_size(n), m_capacity(num_words(n)), m_allocator(alloc)
+        {
+            m_data = m_allocator.allocate(m_capacity);
+        }
+
+        BitVector(const BitVector& other)
+            : m_size(other.m_size),
+              m_allocator(alloc_traits::select_on_container_copy_construction(other.m_allocator))
+        {
+            allocate_memory(num_words(m_size));
+            std::copy(other.m_data, other.m_data + num_words(m_size), m_data);
+        }
+
+        // Inline words are copied; a heap block changes hands.
+        BitVector(BitVector&& other) noexcept
+            : m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity),
+              m_allocator(std::move(other.m_allocator))
+        {
+            if (other.is_inline()) {
+                m_data = this->inline_data();
+                std::copy(other.m_data, other.m_data + num_words(m_size), m_data);
+                other.m_size = 0;
+                return;
+            }
+            other.m_data = nullptr;
+            other.m_size = 0;
+            other.m_capacity = 0;
+        }
+
+        // Reuses the current storage when it holds other.size() bits.  The
+        // allocator is only replaced when it propagates on copy assignment.
+        BitVector& operator=(const BitVector& other)
+        {
+            if (this == &other)
+                return *this;
+            const size_t words = num_words(other.m_size);
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                if (!detail::allocators_equal(m_allocator, other.m_allocator)) {
+                    release();
+                    m_allocator = other.m_allocator;
+                }
+            }
+            if (words > m_capacity)
+            {
+                release();
+                allocate_memory(words);
+            }
+            std::copy(other.m_data, other.m_data + words, m_data);
+            m_size = other.m_size;
+            return *this;
+        }
+
+        // Takes other's storage when the allocators allow it; otherwise
+        // copies the words into this vector's own storage.
+        BitVector& operator=(BitVector&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                                         alloc_traits::is_always_equal::value)
+        {
+            if (this == &other)
+                return *this;
+            if constexpr (!alloc_traits::propagate_on_container_move_assignment::value) {
+                if (!detail::allocators_equal(m_allocator, other.m_allocator))
+                    return *this = static_cast<const BitVector&>(other);
+            }
+            if (other.is_inline()) {
+                *this = static_cast<const BitVector&>(other);
+                other.m_size = 0;
+                return *this;
+            }
+            release();
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+                m_allocator = std::move(other.m_allocator);
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_capacity = other.m_capacity;
+            other.m_data = nullptr;
+            other.m_size = 0;
+            other.m_capacity = 0;
+            return *this;
+        }
+
+        // Exchanges the storage; allocators are exchanged only when they
+        // propagate on swap, and must otherwise compare equal.
+        void swap(BitVector& other) noexcept
+        {
+            using std::swap;
+            if (is_inline() || other.is_inline()) {
+                // Inline words move by copying, which never allocates here:
+                // each side only receives words that fit inline.
+                BitVector tmp(std::move(other));
+                other = std::move(*this);
+                *this = std::move(tmp);
+                return;
+            }
+            swap(m_data, other.m_data);
+            swap(m_size, other.m_size);
+            swap(m_capacity, other.m_capacity);
+            if constexpr (alloc_traits::propagate_on_container_swap::value)
+                swap(m_allocator, other.m_allocator);
+        }
+
+        friend void swap(BitVector& a, BitVector& b) noexcept
+        {
+            a.swap(b);
+        }
+
+        // Evaluates a lazy bitwise expression such as (a & b) | (c & ~d) in
+        // a single pass over its operands.
+        template<typename E, typename = std::enable_if_t<detail::is_bit_expr<E>::value>>
+        BitVector(const E& expr)
+            : BitVector(expr.size(), uninitialized_tag())
+        {
+            detail::eval_kernel<ALIGN>(m_data, expr, num_words(m_size));
+        }
+
+        // Element-wise expressions may read from *this while it is written.
+        template<typename E, typename = std::enable_if_t<detail::is_bit_expr<E>::value>>
+        BitVector& operator=(const E& expr)
+        {
+            const size_t n = expr.size();
+            if constexpr (detail::has_reallocate<Allocator>::value) {
+                // A vector that has to grow is not an operand (operands have
+                // size n), so it can grow in place; allocators such as
+                // MappedAllocator cannot hand out a second block anyway.
+                reserve(n);
+            }
+            if (num_words(n) > m_capacity)
+            {
+                BitVector result(n, uninitialized_tag(), m_allocator);
+                detail::eval_kernel<ALIGN>(result.m_data, expr, num_words(n));
+                swap(result);
+            }
+            else
+            {
+                detail::eval_kernel<ALIGN>(m_data, expr, num_words(n));
+            }
+            m_size = n;
+            return *this;
+        }
+
+        ~BitVector()
+        {
+            deallocate_memory();
+        }
+
+        Allocator get_allocator() const
+        {
+            return m_allocator;
+        }
+
+        reference operator[](size_t pos)
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= m_size){
+                std::stringstream  ss;
+                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+
+            size_t word_index = pos >> WORD_SHIFT;
+            BitType mask = static_cast<BitType>(1) << (pos & (WORD_BITS - 1));
+            return BitReference<Allocator>(&m_data[word_index], mask);
+        }
+
+        bool operator[](size_t pos) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= m_size){
+                std::stringstream  ss;
+                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            size_t word_index = pos >> WORD_SHIFT;
+            BitType mask = static_cast<BitType>(1) << (pos & (WORD_BITS - 1));
+            return (m_data[word_index] & mask) != 0;
+        }
+        inline void set_bit(size_t pos, bool value){
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= m_size){
+                std::stringstream  ss;
+                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            BitType mask = 1UL << (pos % WORD_BITS);
+            BitType * ptr = &m_data[pos / WORD_BITS];
+            if (value)
+                *ptr |= mask;
+            else
+                *ptr &= ~mask;
+        }
+        inline void set_bit_true_unsafe(const size_t& pos) const {
+            BitType mask = 1UL << (pos % WORD_BITS);
+            BitType * ptr = &m_data[pos / WORD_BITS];
+            *ptr |= mask;
+        }
+        // Sets `size` bits pos, pos + stride, ...; kept for existing callers,
+        // forwards to the set_stride engine.
+        inline void qset_bit_true_6_v2(size_t pos,const size_t stride,const size_t size) const {
+            detail::stride_kernel(m_data, pos, stride, size, true);
+        }
+        inline void set_bit_true_6(size_t pos, const size_t stride) {
+            //_mm_prefetch((char *) &m_data[pos + 6 * stride / WORD_BITS], _MM_HINT_T0);
+            for (int i = 0; i < 6; i++) {
+                BitType mask = 1UL << (pos % WORD_BITS);
+                BitType *ptr = &m_data[pos / WORD_BITS];
+                *ptr |= mask;
+                pos += stride;
+            }
+        }
+
+        // Sets (or clears, when value is false) the `count` bits start,
+        // start + stride, ..., start + (count - 1) * stride.
+        void set_stride(size_t start, size_t stride, size_t count, bool value = true)
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (count && start + (count - 1) * stride >= m_size){
+                std::stringstream  ss;
+                ss << "BitVector stride out of range" << " start: " << start << " stride: " << stride
+                   << " count: " << count << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            detail::stride_kernel(m_data, start, stride, count, value);
+        }
+        void incrementUntilZero(size_t& pos){
+            // Ensure the position is within bounds
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= m_size){
+                std::stringstream  ss;
+                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            const size_t zero = find_next_zero(pos);
+            pos = zero == npos ? m_size : zero;
+        }
+
+        // First set bit in [pos, size()), or npos.
+        size_t find_next_one(size_t pos) const
+        {
+            return find_next<false>(pos);
+        }
+
+        // First clear bit in [pos, size()), or npos.
+        size_t find_next_zero(size_t pos) const
+        {
+            return find_next<true>(pos);
+        }
+
+        // Last set bit in [0, pos), or npos.
+        size_t find_prev_one(size_t pos) const
+        {
+            return find_prev<false>(pos);
+        }
+
+        // Last clear bit in [0, pos), or npos.
+        size_t find_prev_zero(size_t pos) const
+        {
+            return find_prev<true>(pos);
+        }
+
+        size_t find_first_one() const
+        {
+            return find_next_one(0);
+        }
+
+        size_t find_first_zero() const
+        {
+            return find_next_zero(0);
+        }
+
+        size_t find_last_one() const
+        {
+            return find_prev_one(m_size);
+        }
+
+        size_t find_last_zero() const
+        {
+            return find_prev_zero(m_size);
+        }
+
+
+        void push_back(bool value)
+        {
+            if (m_size == m_capacity * WORD_BITS)
+            {
+                reserve(m_capacity ? m_capacity * WORD_BITS * 2 : WORD_BITS);
+            }
+
+            size_t word_index = m_size >> WORD_SHIFT;
+            BitType mask = static_cast<BitType>(1)
+                           << (m_size & (WORD_BITS - 1));
+            if (value)
+                m_data[word_index] |= mask;
+            else
+                m_data[word_index] &= ~mask;
+            ++m_size;
+        }
+
+        // Appends n bits; bit i is set when flags[i] is non-zero.  The flags
+        // are packed 64 per instruction sequence (detail::pack_bytes), straight
+        // into the vector when size() is a multiple of 64 and through
+        // append_words otherwise.
+        void append_bools(const uint8_t* flags, size_t n)
+        {
+            if (n == 0)
+                return;
+            grow_for_append(n);
+            if ((m_size & (WORD_BITS - 1)) == 0) {
+                detail::pack_bytes(m_data + (m_size >> WORD_SHIFT), flags, n);
+                m_size += n;
+                return;
+            }
+            BitType packed[64];
+            const size_t chunk = sizeof(packed) * 8;
+            for (; n > chunk; n -= chunk, flags += chunk) {
+                detail::pack_bytes(packed, flags, chunk);
+                append_words(packed, chunk);
+            }
+            detail::pack_bytes(packed, flags, n);
+            append_words(packed, n);
+        }
+
+        void append_bools(const bool* flags, size_t n)
+        {
+            append_bools(reinterpret_cast<const uint8_t*>(flags), n);
+        }
+
+        // Replaces the contents with n bits, bit i set when bytes[i] is
+        // non-zero, reusing the storage when it is large enough.
+        void assign_from_bytes(const uint8_t* bytes, size_t n)
+        {
+            if (n > m_capacity * WORD_BITS)
+            {
+                release();
+                allocate_memory(num_words(n));
+            }
+            m_size = n;
+            detail::pack_bytes(m_data, bytes, n);
+        }
+
+        // Appends the first nbits bits of words.  Bits past nbits in the last
+        // source word are ignored; words must not point into this vector.
+        void append_words(const BitType* words, size_t nbits)
+        {
+            if (nbits == 0)
+                return;
+            grow_for_append(nbits);
+            const unsigned int off = m_size & (WORD_BITS - 1);
+            BitType* dst = m_data + (m_size >> WORD_SHIFT);
+            const size_t src_words = num_words(nbits);
+            if (off == 0) {
+                std::memcpy(dst, words, src_words * sizeof(BitType));
+            } else {
+                BitType carry = dst[0] & ((static_cast<BitType>(1) << off) - 1);
+                for (size_t i = 0; i < src_words; ++i) {
+                    dst[i] = carry | (words[i] << off);
+                    carry = words[i] >> (WORD_BITS - off);
+                }
+                if (src_words < num_words(off + nbits))
+                    dst[src_words] = carry;
+            }
+            m_size += nbits;
+        }
+
+        void reserve(size_t new_capacity)
+        {
+            if (new_capacity > m_capacity * WORD_BITS)
+            {
+                size_t new_word_count = num_words(new_capacity);
+
+                if constexpr (detail::has_reallocate<Allocator>::value) {
+                    if (m_data && !is_inline()) {
+                        m_data = m_allocator.reallocate(m_data, m_capacity, new_word_count);
+                        m_capacity = new_word_count;
+                        return;
+                    }
+                }
+                BitType *old_data = m_data;
+                const size_t old_capacity = m_capacity;
+                const bool was_inline = is_inline();
+                allocate_memory(new_word_count);
+                if (old_data)
+                    std::copy(old_data, old_data + old_capacity, m_data);
+                if (old_data && !was_inline)
+                    m_allocator.deallocate(old_data, old_capacity);
+            }
+        }
+
+        // Releases the words past num_words(size()), moving the bits back
+        // inline when they fit.
+        void shrink_to_fit()
+        {
+            const size_t words = num_words(m_size);
+            if (words == m_capacity || is_inline())
+                return;
+            if (words == 0) {
+                release();
+                return;
+            }
+            if constexpr (detail::has_reallocate<Allocator>::value) {
+                if (words > INLINE_WORDS) {
+                    m_data = m_allocator.reallocate(m_data, m_capacity, words);
+                    m_capacity = words;
+                    return;
+                }
+            }
+            BitType *old_data = m_data;
+            const size_t old_capacity = m_capacity;
+            allocate_memory(words);
+            std::copy(old_data, old_data + words, m_data);
+            m_allocator.deallocate(old_data, old_capacity);
+        }
+
+        // Removes every bit and keeps the storage.
+        void clear()
+        {
+            m_size = 0;
+        }
+
+        void assign(size_t n, bool value)
+        {
+            if (n > m_capacity * WORD_BITS)
+            {
+                release();
+                allocate_memory(num_words(n));
+            }
+            m_size = n;
+            std::memset(m_data, value ? ~0 : 0, m_capacity * sizeof(BitType));
+        }
+
+        BitVector& operator&=(const BitVector& other)
+        {
+            check_same_size(other);
+            detail::bitwise_kernel<detail::and_op, ALIGN>(m_data, m_data, other.m_data, num_words(m_size));
+            return *this;
+        }
+
+        BitVector& operator|=(const BitVector& other)
+        {
+            check_same_size(other);
+            detail::bitwise_kernel<detail::or_op, ALIGN>(m_data, m_data, other.m_data, num_words(m_size));
+            return *this;
+        }
+
+        BitVector& operator^=(const BitVector& other)
+        {
+            check_same_size(other);
+            detail::bitwise_kernel<detail::xor_op, ALIGN>(m_data, m_data, other.m_data, num_words(m_size));
+            return *this;
+        }
+
+        template<typename E, typename = std::enable_if_t<detail::is_bit_expr<E>::value>>
+        BitVector& operator&=(const E& expr)
+        {
+            return *this = *this & expr;
+        }
+
+        template<typename E, typename = std::enable_if_t<detail::is_bit_expr<E>::value>>
+        BitVector& operator|=(const E& expr)
+        {
+            return *this = *this | expr;
+        }
+
+        template<typename E, typename = std::enable_if_t<detail::is_bit_expr<E>::value>>
+        BitVector& operator^=(const E& expr)
+        {
+            return *this = *this ^ expr;
+        }
+
+        // Clears every bit that is set in `other` (this &= ~other).
+        BitVector& andnot(const BitVector& other)
+        {
+            check_same_size(other);
+            detail::bitwise_kernel<detail::andnot_op, ALIGN>(m_data, m_data, other.m_data, num_words(m_size));
+            return *this;
+        }
+
+        // Inverts every bit.  Bits past size() in the last word are not
+        // meaningful and may change.
+        BitVector& flip()
+        {
+            detail::flip_kernel<ALIGN>(m_data, m_data, num_words(m_size));
+            return *this;
+        }
+
+        // Writes base + i for every set bit i to out and returns how many
+        // were written.  out must have room for count() entries, and every
+        // base + i must fit in 32 bits.
+        size_t extract_ones(uint32_t* out, size_t base = 0) const
+        {
+            size_t pos = 0;
+            return extract_ones_impl(out, npos, pos, base);
+        }
+
+        size_t extract_ones(uint64_t* out, size_t base = 0) const
+        {
+            size_t pos = 0;
+            return extract_ones_impl(out, npos, pos, base);
+        }
+
+        // Streaming variant for bounded buffers: writes at most `capacity`
+        // positions of set bits in [pos, size()) and moves pos to the first
+        // bit not yet reported.  Call again with the same pos until it
+        // returns 0.
+        size_t extract_ones(uint32_t* out, size_t capacity, size_t& pos, size_t base = 0) const
+        {
+            return extract_ones_impl(out, capacity, pos, base);
+        }
+
+        size_t extract_ones(uint64_t* out, size_t capacity, size_t& pos, size_t base = 0) const
+        {
+            return extract_ones_impl(out, capacity, pos, base);
+        }
+
+        // Writes bit i of [l, r) to out[i - l]: 0 or 1 bytes, bools, or
+        // int32 lanes of 0 or -1 for use as blend masks.  The overloads
+        // without a range unpack the whole vector.  See detail::unpack_bits.
+        void unpack_to_bytes(uint8_t* out) const
+        {
+            detail::unpack_bits(m_data, 0, m_size, out);
+        }
+
+        void unpack_to_bytes(uint8_t* out, size_t l, size_t r) const
+        {
+            check_range(l, r);
+            detail::unpack_bits(m_data, l, r - l, out);
+        }
+
+        void unpack_to_bool(bool* out) const
+        {
+            unpack_to_bytes(reinterpret_cast<uint8_t*>(out));
+        }
+
+        void unpack_to_bool(bool* out, size_t l, size_t r) const
+        {
+            unpack_to_bytes(reinterpret_cast<uint8_t*>(out), l, r);
+        }
+
+        void unpack_to_int32_mask(int32_t* out) const
+        {
+            detail::unpack_bits(m_data, 0, m_size, out);
+        }
+
+        void unpack_to_int32_mask(int32_t* out, size_t l, size_t r) const
+        {
+            check_range(l, r);
+            detail::unpack_bits(m_data, l, r - l, out);
+        }
+
+        // Number of set bits in the whole vector.
+        size_t count() const
+        {
+            const size_t full = m_size >> WORD_SHIFT;
+            size_t total = detail::popcount_kernel(detail::word_source<ALIGN>{m_data}, full);
+            if (m_size & (WORD_BITS - 1))
+                total += detail::popcount_word(m_data[full] & detail::tail_mask(m_size));
+            return total;
+        }
+
+        // Number of set bits in the half-open range [l, r).
+        size_t count(size_t l, size_t r) const
+        {
+            check_range(l, r);
+            return detail::count_bits(m_data, l, r);
+        }
+
+        // Parallel overloads of the bulk operations.  `policy` is an
+        // execution policy such as bowen::ParallelPolicy from parallel.hpp;
+        // results are identical to the serial versions.
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        void assign(const Policy& policy, size_t n, bool value)
+        {
+            if (n > m_capacity * WORD_BITS)
+            {
+                release();
+                allocate_memory(num_words(n));
+            }
+            m_size = n;
+            BitType* dst = m_data;
+            const int fill = value ? ~0 : 0;
+            policy.for_each(dst, m_capacity, [dst, fill](size_t b, size_t e) {
+                std::memset(dst + b, fill, (e - b) * sizeof(BitType));
+            });
+        }
+
+        // Makes this a copy of `other`, reusing the storage when it is large
+        // enough.
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        void assign(const Policy& policy, const BitVector& other)
+        {
+            if (this == &other)
+                return;
+            if (other.m_size > m_capacity * WORD_BITS)
+            {
+                release();
+                allocate_memory(num_words(other.m_size));
+            }
+            m_size = other.m_size;
+            BitType* dst = m_data;
+            const BitType* src = other.m_data;
+            policy.for_each(dst, num_words(m_size), [dst, src](size_t b, size_t e) {
+                std::memcpy(dst + b, src + b, (e - b) * sizeof(BitType));
+            });
+        }
+
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        BitVector& and_assign(const Policy& policy, const BitVector& other)
+        {
+            return parallel_bitwise<detail::and_op>(policy, other);
+        }
+
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        BitVector& or_assign(const Policy& policy, const BitVector& other)
+        {
+            return parallel_bitwise<detail::or_op>(policy, other);
+        }
+
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        BitVector& xor_assign(const Policy& policy, const BitVector& other)
+        {
+            return parallel_bitwise<detail::xor_op>(policy, other);
+        }
+
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        BitVector& andnot(const Policy& policy, const BitVector& other)
+        {
+            return parallel_bitwise<detail::andnot_op>(policy, other);
+        }
+
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        size_t count(const Policy& policy) const
+        {
+            const size_t full = m_size >> WORD_SHIFT;
+            const BitType* data = m_data;
+            size_t total = policy.reduce(data, full, static_cast<size_t>(0), [data](size_t b, size_t e) {
+                return detail::popcount_kernel(detail::word_source<CHUNK_ALIGN>{data + b}, e - b);
+            }, [](size_t x, size_t y) { return x + y; });
+            if (m_size & (WORD_BITS - 1))
+                total += detail::popcount_word(m_data[full] & detail::tail_mask(m_size));
+            return total;
+        }
+
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        size_t find_first_one(const Policy& policy) const
+        {
+            return parallel_find_first<false>(policy);
+        }
+
+        template<typename Policy, typename = std::enable_if_t<detail::is_execution_policy<Policy>::value>>
+        size_t find_first_zero(const Policy& policy) const
+        {
+            return parallel_find_first<true>(policy);
+        }
+
+        // Moves every bit i to i + k; the low k bits become zero and bits
+        // shifted past size() are dropped.
+        BitVector& shift_left(size_t k)
+        {
+            detail::shift_left_words(m_data, m_data, num_words(m_size), k);
+            return *this;
+        }
+
+        // Moves every bit i to i - k; the high k bits become zero.
+        BitVector& shift_right(size_t k)
+        {
+            detail::shift_right_words(m_data, m_data, num_words(m_size), k, detail::tail_mask(m_size));
+            return *this;
+        }
+
+        // Out-of-place shifts into a preallocated vector of the same size.
+        void shift_left_into(BitVector& dst, size_t k) const
+        {
+            check_same_size(dst);
+            detail::shift_left_words(dst.m_data, m_data, num_words(m_size), k);
+        }
+
+        void shift_right_into(BitVector& dst, size_t k) const
+        {
+            check_same_size(dst);
+            detail::shift_right_words(dst.m_data, m_data, num_words(m_size), k, detail::tail_mask(m_size));
+        }
+
+        // dst = this rotated so that bit i moves to (i + k) % size().
+        // dst must be a distinct vector of the same size.
+        void rotate_left_into(BitVector& dst, size_t k) const
+        {
+            check_same_size(dst);
+            if (m_size == 0)
+                return;
+            k %= m_size;
+            const size_t words = num_words(m_size);
+            detail::shift_left_words(dst.m_data, m_data, words, k);
+            if (k)
+                detail::shift_right_words<true>(dst.m_data, m_data, words, m_size - k, detail::tail_mask(m_size));
+        }
+
+        void rotate_right_into(BitVector& dst, size_t k) const
+        {
+            rotate_left_into(dst, m_size ? m_size - k % m_size : 0);
+        }
+
+        // In-place rotations go through one temporary copy.
+        BitVector& rotate_left(size_t k)
+        {
+            const BitVector src(*this);
+            src.rotate_left_into(*this, k);
+            return *this;
+        }
+
+        BitVector& rotate_right(size_t k)
+        {
+            const BitVector src(*this);
+            src.rotate_right_into(*this, k);
+            return *this;
+        }
+
+        BitVector& operator<<=(size_t k)
+        {
+            return shift_left(k);
+        }
+
+        BitVector& operator>>=(size_t k)
+        {
+            return shift_right(k);
+        }
+
+        friend BitVector operator<<(const BitVector& a, size_t k)
+        {
+            BitVector result(a.m_size, uninitialized_tag());
+            a.shift_left_into(result, k);
+            return result;
+        }
+
+        friend BitVector operator>>(const BitVector& a, size_t k)
+        {
+            BitVector result(a.m_size, uninitialized_tag());
+            a.shift_right_into(result, k);
+            return result;
+        }
+
+        // Sets every bit in [l, r).
+        void set_range(size_t l, size_t r)
+        {
+            modify_range(l, r, detail::range_op::set);
+        }
+
+        // Clears every bit in [l, r).
+        void clear_range(size_t l, size_t r)
+        {
+            modify_range(l, r, detail::range_op::clear);
+        }
+
+        // Inverts every bit in [l, r).
+        void flip_range(size_t l, size_t r)
+        {
+            modify_range(l, r, detail::range_op::flip);
+        }
+
+        // True if every bit in [l, r) is set (vacuously true when l == r).
+        bool all(size_t l, size_t r) const
+        {
+            return !range_has_other<true>(l, r);
+        }
+
+        // True if at least one bit in [l, r) is set.
+        bool any(size_t l, size_t r) const
+        {
+            return range_has_other<false>(l, r);
+        }
+
+        // True if no bit in [l, r) is set.
+        bool none(size_t l, size_t r) const
+        {
+            return !range_has_other<false>(l, r);
+        }
+
+        bool all() const
+        {
+            return all(0, m_size);
+        }
+
+        bool any() const
+        {
+            return any(0, m_size);
+        }
+
+        bool none() const
+        {
+            return none(0, m_size);
+        }
+
+        friend size_t and_count(const BitVector& a, const BitVector& b)
+        {
+            return fused_count<detail::and_op>(a, b);
+        }
+
+        friend size_t or_count(const BitVector& a, const BitVector& b)
+        {
+            return fused_count<detail::or_op>(a, b);
+        }
+
+        friend size_t xor_count(const BitVector& a, const BitVector& b)
+        {
+            return fused_count<detail::xor_op>(a, b);
+        }
+
+        // Number of bits set in a but not in b.
+        friend size_t andnot_count(const BitVector& a, const BitVector& b)
+        {
+            return fused_count<detail::andnot_op>(a, b);
+        }
+
+        BitType *data() {
+            return m_data;
+        }
+
+        const BitType *data() const {
+            return m_data;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        // Views of the bits in [l, r).  Nothing is copied; a view is
+        // invalidated by anything that reallocates the vector.
+        ConstBitSpan subspan(size_t l, size_t r) const;
+        BitSpan subspan(size_t l, size_t r);
+
+        iterator begin()
+        {
+            return iterator(m_data, 0);
+        }
+
+        iterator end()
+        {
+            return iterator(m_data + (m_size >> WORD_SHIFT), m_size & (WORD_BITS - 1));
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator(m_data, 0);
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(m_data + (m_size >> WORD_SHIFT), m_size & (WORD_BITS - 1));
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+    };
+
+    // BitVector holding up to InlineBits bits without allocating, e.g.
+    // SmallBitVector<256> for short per-row masks.
+    template<std::size_t InlineBits, typename Allocator = std::allocator<BitType>>
+    using SmallBitVector = BitVector<Allocator, InlineBits>;
+
+    // Lazy bitwise expressions.  The operators below return lightweight
+    // nodes instead of vectors; nothing is computed until the expression is
+    // assigned to a BitVector or a terminal operation (count, any, none, all)
+    // runs.  Evaluation is one fused SIMD pass: each output word is computed
+    // in registers from the matching word of every operand, so each operand
+    // is streamed from memory once and no temporaries are allocated.
+    //
+    // Nodes reference the vectors they were built from, so an expression must
+    // not outlive its operands (beware of `auto e = a & b;`).
+    template<typename Derived>
+    class BitExpr : public detail::bit_expr_tag
+    {
+        const Derived& self() const
+        {
+            return static_cast<const Derived&>(*this);
+        }
+
+    public:
+        size_t count() const
+        {
+            const size_t n = self().size();
+            const size_t full = n >> WORD_SHIFT;
+            size_t total = detail::popcount_kernel(self(), full);
+            if (n & (WORD_BITS - 1))
+                total += detail::popcount_word(self().word(full) & detail::tail_mask(n));
+            return total;
+        }
+
+        bool any() const
+        {
+            const size_t n = self().size();
+            const size_t full = n >> WORD_SHIFT;
+            if (detail::any_kernel(self(), full))
+                return true;
+            return (n & (WORD_BITS - 1)) && (self().word(full) & detail::tail_mask(n)) != 0;
+        }
+
+        bool none() const
+        {
+            return !any();
+        }
+
+        bool all() const;
+    };
+
+    // Leaf node: the words of a BitVector.
+    template<std::size_t Align>
+    class BitVectorLeaf : public BitExpr<BitVectorLeaf<Align>>
+    {
+        const BitType* m_data;
+        size_t m_size;
+
+    public:
+        BitVectorLeaf(const BitType* data, size_t size)
+            : m_data(data), m_size(size) {}
+
+        size_t size() const { return m_size; }
+        BitType word(size_t i) const { return m_data[i]; }
+        __m256i vec256(size_t i) const { return detail::load256<Align>(m_data + i); }
+#if defined(__AVX512F__)
+        __m512i vec512(size_t i) const { return detail::load512<Align>(m_data + i); }
+#endif
+    };
+
+    template<typename Op, typename L, typename R>
+    class BitBinaryExpr : public BitExpr<BitBinaryExpr<Op, L, R>>
+    {
+        L m_lhs;
+        R m_rhs;
+
+    public:
+        BitBinaryExpr(const L& lhs, const R& rhs)
+            : m_lhs(lhs), m_rhs(rhs)
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (lhs.size() != rhs.size()){
+                std::stringstream  ss;
+                ss << "BitVector size mismatch" << " lhs: " << lhs.size() << " rhs: " << rhs.size() << std::endl;
+                throw std::invalid_argument(ss.str());
+            }
+#endif
+        }
+
+        size_t size() const { return m_lhs.size(); }
+        BitType word(size_t i) const { return Op::apply(m_lhs.word(i), m_rhs.word(i)); }
+        __m256i vec256(size_t i) const { return Op::apply(m_lhs.vec256(i), m_rhs.vec256(i)); }
+#if defined(__AVX512F__)
+        __m512i vec512(size_t i) const { return Op::apply(m_lhs.vec512(i), m_rhs.vec512(i)); }
+#endif
+    };
+
+    template<typename E>
+    class BitNotExpr : public BitExpr<BitNotExpr<E>>
+    {
+        E m_expr;
+
+    public:
+        explicit BitNotExpr(const E& expr)
+            : m_expr(expr) {}
+
+        size_t size() const { return m_expr.size(); }
+        BitType word(size_t i) const { return ~m_expr.word(i); }
+        __m256i vec256(size_t i) const { return _mm256_xor_si256(m_expr.vec256(i), _mm256_set1_epi64x(-1)); }
+#if defined(__AVX512F__)
+        __m512i vec512(size_t i) const { return _mm512_xor_si512(m_expr.vec512(i), _mm512_set1_epi64(-1)); }
+#endif
+    };
+
+    template<typename Derived>
+    bool BitExpr<Derived>::all() const
+    {
+        return BitNotExpr<Derived>(self()).none();
+    }
+
+    // Non-owning view of `size` bits starting at an arbitrary bit offset
+    // of a word array, e.g. bits 1000..5000 of a BitVector.  The read-only
+    // bulk operations (count, any/all/none, find_*, extract_ones) run on the
+    // underlying words in the view's bit coordinates, so they cost the same
+    // whatever the offset.  As an expression leaf a span yields its bits
+    // realigned to word boundaries: a plain load when the offset is
+    // word-aligned, otherwise a shift-merge of two neighbouring words.
+    //
+    //     size_t ones = v.subspan(1000, 5000).count();
+    //     BitVector<> both = a.subspan(7, 7 + n) & b;       // n == b.size()
+    //     bool same = a.subspan(0, 64) == b.subspan(3, 67);
+    //
+    // Like the lazy expressions, a span must not outlive its storage.
+    class ConstBitSpan : public BitExpr<ConstBitSpan>
+    {
+    protected:
+        const BitType* m_data; // word holding the first bit
+        unsigned int m_offset; // position of the first bit in *m_data
+        size_t m_size;
+        size_t m_words;        // words holding bits of the span
+
+        void check_pos(size_t pos) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= m_size){
+                std::stringstream  ss;
+                ss << "BitSpan index out of range" << " pos: " << pos << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#else
+            (void)pos;
+#endif
+        }
+
+        void check_range(size_t l, size_t r) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (l > r || r > m_size){
+                std::stringstream  ss;
+                ss << "BitSpan range out of range" << " l: " << l << " r: " << r << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#else
+            (void)l;
+            (void)r;
+#endif
+        }
+
+        template<bool Zero>
+        size_t find_next(size_t pos) const
+        {
+            const size_t found = detail::find_next_bit<Zero>(m_data, m_offset + std::min(pos, m_size), m_offset + m_size);
+            return found == npos ? npos : found - m_offset;
+        }
+
+        template<bool Zero>
+        size_t find_prev(size_t pos) const
+        {
+            const size_t found = detail::find_prev_bit<Zero>(m_data, m_offset, m_offset + std::min(pos, m_size));
+            return found == npos ? npos : found - m_offset;
+        }
+
+        template<typename T>
+        size_t extract_ones_impl(T* out, size_t capacity, size_t& pos, size_t base) const
+        {
+            size_t abs = m_offset + std::min(pos, m_size);
+            const size_t written = detail::extract_ones_bits(m_data, m_offset + m_size, out, capacity, abs, base - m_offset);
+            pos = abs - m_offset;
+            return written;
+        }
+
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        ConstBitSpan()
+            : m_data(nullptr), m_offset(0), m_size(0), m_words(0) {}
+
+        ConstBitSpan(const BitType* data, size_t offset, size_t size)
+            : m_data(data + (offset >> WORD_SHIFT)),
+              m_offset(static_cast<unsigned int>(offset & (WORD_BITS - 1))),
+              m_size(size),
+              m_words((m_offset + size + WORD_BITS - 1) / WORD_BITS) {}
+
+        template<typename Allocator, std::size_t InlineBits>
+        ConstBitSpan(const BitVector<Allocator, InlineBits>& v)
+            : ConstBitSpan(v.data(), 0, v.size()) {}
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        // Word holding the first bit, and the bit's position in it.
+        const BitType* data() const
+        {
+            return m_data;
+        }
+
+        unsigned int offset() const
+        {
+            return m_offset;
+        }
+
+        bool operator[](size_t pos) const
+        {
+            check_pos(pos);
+            const size_t abs = m_offset + pos;
+            return (m_data[abs >> WORD_SHIFT] >> (abs & (WORD_BITS - 1))) & 1;
+        }
+
+        ConstBitSpan subspan(size_t l, size_t r) const
+        {
+            check_range(l, r);
+            return ConstBitSpan(m_data, m_offset + l, r - l);
+        }
+
+        size_t count() const
+        {
+            return detail::count_bits(m_data, m_offset, m_offset + m_size);
+        }
+
+        size_t count(size_t l, size_t r) const
+        {
+            check_range(l, r);
+            return detail::count_bits(m_data, m_offset + l, m_offset + r);
+        }
+
+        bool any() const
+        {
+            return detail::range_has_other<false>(m_data, m_offset, m_offset + m_size);
+        }
+
+        bool none() const
+        {
+            return !any();
+        }
+
+        bool all() const
+        {
+            return !detail::range_has_other<true>(m_data, m_offset, m_offset + m_size);
+        }
+
+        size_t find_next_one(size_t pos) const
+        {
+            return find_next<false>(pos);
+        }
+
+        size_t find_next_zero(size_t pos) const
+        {
+            return find_next<true>(pos);
         }
 
-        BitReference& operator=(bool value)
+        size_t find_prev_one(size_t pos) const
         {
-            if (value)
-                *m_ptr |= m_mask;
-            else
-                *m_ptr &= ~m_mask;
-            return *this;
+            return find_prev<false>(pos);
         }
 
-        BitReference& operator=(const BitReference& ref)
+        size_t find_prev_zero(size_t pos) const
         {
-            return *this = static_cast<bool>(ref);
+            return find_prev<true>(pos);
         }
 
-        void flip()
+        size_t find_first_one() const
         {
-            *m_ptr ^= m_mask;
+            return find_next_one(0);
         }
-    };
-    template<typename Allocator = std::allocator<BitType>>
-    class BitIterator {
-        using iterator_category = std::random_access_iterator_tag;
-        using value_type = bool;
-        using difference_type = std::ptrdiff_t;
-        using pointer = void; // Not applicable for bit iterators
-        using reference = BitReference<Allocator>;
 
-    private:
-        BitType* m_ptr;
-        unsigned int m_offset;
+        size_t find_first_zero() const
+        {
+            return find_next_zero(0);
+        }
 
-    public:
-        BitIterator(BitType* ptr = nullptr, unsigned int offset = 0)
-            : m_ptr(ptr), m_offset(offset) {}
+        size_t find_last_one() const
+        {
+            return find_prev_one(m_size);
+        }
 
-        reference operator*() const {
-            return BitReference<Allocator>(m_ptr, 1UL << m_offset);
+        size_t find_last_zero() const
+        {
+            return find_prev_zero(m_size);
         }
 
-        BitIterator& operator++() {
-            if (++m_offset == WORD_BITS) {
-                m_offset = 0;
-                ++m_ptr;
-            }
-            return *this;
+        // Same contracts as the BitVector overloads, with positions
+        // relative to the start of the span.
+        size_t extract_ones(uint32_t* out, size_t base = 0) const
+        {
+            size_t pos = 0;
+            return extract_ones_impl(out, npos, pos, base);
         }
 
-        BitIterator operator++(int) {
-            BitIterator tmp = *this;
-            ++(*this);
-            return tmp;
+        size_t extract_ones(uint64_t* out, size_t base = 0) const
+        {
+            size_t pos = 0;
+            return extract_ones_impl(out, npos, pos, base);
         }
 
-        BitIterator& operator--() {
-            if (m_offset-- == 0) {
-                m_offset = WORD_BITS - 1;
-                --m_ptr;
-            }
-            return *this;
+        size_t extract_ones(uint32_t* out, size_t capacity, size_t& pos, size_t base = 0) const
+        {
+            return extract_ones_impl(out, capacity, pos, base);
         }
 
-        bool operator==(const BitIterator& other) const {
-            return m_ptr == other.m_ptr && m_offset == other.m_offset;
+        size_t extract_ones(uint64_t* out, size_t capacity, size_t& pos, size_t base = 0) const
+        {
+            return extract_ones_impl(out, capacity, pos, base);
         }
 
-        bool operator!=(const BitIterator& other) const {
-            return !(*this == other);
+        // Expression leaf interface: word i holds bits [64i, 64i + 64) of
+        // the span.  The last word is only read as far as the span reaches.
+        BitType word(size_t i) const
+        {
+            const BitType lo = m_data[i] >> m_offset;
+            if (i + 1 >= m_words)
+                return lo;
+            // Shifting by (64 - offset) in two steps keeps offset 0 defined.
+            return lo | ((m_data[i + 1] << 1) << (WORD_BITS - 1 - m_offset));
         }
-    };
-    template<typename Allocator = std::allocator<BitType>>
-    class BitVector
-    {
-    private:
-        BitType* m_data;
-        size_t m_size;
-        size_t m_capacity;
-        Allocator m_allocator;
 
-        void allocate_memory(size_t word_count) {
-            m_data = m_allocator.allocate(word_count);
+        __m256i vec256(size_t i) const
+        {
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_data + i));
+            if (m_offset == 0)
+                return lo;
+            if (i + 4 >= m_words)
+                return _mm256_set_epi64x(static_cast<long long>(word(i + 3)), static_cast<long long>(word(i + 2)),
+                                         static_cast<long long>(word(i + 1)), static_cast<long long>(word(i)));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_data + i + 1));
+            return _mm256_or_si256(_mm256_srl_epi64(lo, _mm_cvtsi32_si128(static_cast<int>(m_offset))),
+                                   _mm256_sll_epi64(hi, _mm_cvtsi32_si128(static_cast<int>(WORD_BITS - m_offset))));
         }
 
-        void deallocate_memory() {
-            if (m_data) {
-                m_allocator.deallocate(m_data, m_capacity);
-            }
+#if defined(__AVX512F__)
+        __m512i vec512(size_t i) const
+        {
+            const __m512i lo = _mm512_loadu_si512(m_data + i);
+            if (m_offset == 0)
+                return lo;
+            if (i + 8 >= m_words)
+                return _mm512_set_epi64(static_cast<long long>(word(i + 7)), static_cast<long long>(word(i + 6)),
+                                        static_cast<long long>(word(i + 5)), static_cast<long long>(word(i + 4)),
+                                        static_cast<long long>(word(i + 3)), static_cast<long long>(word(i + 2)),
+                                        static_cast<long long>(word(i + 1)), static_cast<long long>(word(i)));
+            const __m512i hi = _mm512_loadu_si512(m_data + i + 1);
+            return _mm512_or_si512(_mm512_srl_epi64(lo, _mm_cvtsi32_si128(static_cast<int>(m_offset))),
+                                   _mm512_sll_epi64(hi, _mm_cvtsi32_si128(static_cast<int>(WORD_BITS - m_offset))));
         }
+#endif
+    };
 
-        static size_t num_words(size_t bits)
+    // Span whose bits can be written.  Like std::span, constness is
+    // shallow: a const BitSpan still writes through to its storage.
+    class BitSpan : public ConstBitSpan
+    {
+    private:
+        BitType* words() const
         {
-            return (bits + WORD_BITS - 1) / WORD_BITS;
+            return const_cast<BitType*>(m_data);
         }
 
     public:
-        typedef BitIterator<Allocator> iterator;
-        typedef bool value_type;
-        typedef size_t size_type;
-        typedef BitReference<Allocator> reference;
+        BitSpan() {}
 
-        BitVector()
-            : m_data(nullptr), m_size(0), m_capacity(0) {}
+        BitSpan(BitType* data, size_t offset, size_t size)
+            : ConstBitSpan(data, offset, size) {}
 
-        explicit BitVector(size_t n, bool value = false)
-            : m_size(n), m_capacity(num_words(n))
+        template<typename Allocator, std::size_t InlineBits>
+        BitSpan(BitVector<Allocator, InlineBits>& v)
+            : ConstBitSpan(v.data(), 0, v.size()) {}
+
+        BitType* data() const
         {
-            allocate_memory(m_capacity);
-            std::memset(m_data, value ? ~0 : 0, m_capacity * sizeof(BitType));
+            return words();
         }
 
-        BitVector(const BitVector& other)
-            : m_size(other.m_size), m_capacity(other.m_capacity)
+        BitReference<> operator[](size_t pos) const
         {
-            allocate_memory(m_capacity);
-            std::copy(other.m_data, other.m_data + m_capacity, m_data);
+            check_pos(pos);
+            const size_t abs = m_offset + pos;
+            return BitReference<>(words() + (abs >> WORD_SHIFT), static_cast<BitType>(1) << (abs & (WORD_BITS - 1)));
         }
 
-        BitVector& operator=(const BitVector& other)
+        void set_bit(size_t pos, bool value) const
         {
-            if (this != &other)
-            {
-                deallocate_memory();
-                m_size = other.m_size;
-                m_capacity = other.m_capacity;
-                m_allocator = other.m_allocator;
-                allocate_memory(m_capacity);
-                std::copy(other.m_data, other.m_data + m_capacity, m_data);
-            }
-            return *this;
+            (*this)[pos] = value;
         }
 
-        ~BitVector()
+        BitSpan subspan(size_t l, size_t r) const
         {
-            deallocate_memory();
+            check_range(l, r);
+            return BitSpan(words(), m_offset + l, r - l);
         }
 
-        reference operator[](size_t pos)
+        void set_range(size_t l, size_t r) const
         {
-#ifndef BITVECTOR_NO_BOUND_CHECK
-            if (pos >= m_size){
-                std::stringstream  ss;
-                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
-                throw std::out_of_range(ss.str());
-            }
-#endif
-
-            size_t word_index = pos >> WORD_SHIFT;
-            BitType mask = static_cast<BitType>(1) << (pos & (WORD_BITS - 1));
-            return BitReference<Allocator>(&m_data[word_index], mask);
+            check_range(l, r);
+            detail::modify_bits(words(), m_offset + l, m_offset + r, detail::range_op::set);
         }
 
-        bool operator[](size_t pos) const
+        void clear_range(size_t l, size_t r) const
         {
-#ifndef BITVECTOR_NO_BOUND_CHECK
-            if (pos >= m_size){
-                std::stringstream  ss;
-                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
-                throw std::out_of_range(ss.str());
-            }
-#endif
-            size_t word_index = pos >> WORD_SHIFT;
-            BitType mask = static_cast<BitType>(1) << (pos & (WORD_BITS - 1));
-            return (m_data[word_index] & mask) != 0;
-        }
-        inline void set_bit(size_t pos, bool value){
-#ifndef BITVECTOR_NO_BOUND_CHECK
-            if (pos >= m_size){
-                std::stringstream  ss;
-                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
-                throw std::out_of_range(ss.str());
-            }
-#endif
-            BitType mask = 1UL << (pos % WORD_BITS);
-            BitType * ptr = &m_data[pos / WORD_BITS];
-            if (value)
-                *ptr |= mask;
-            else
-                *ptr &= ~mask;
+            check_range(l, r);
+            detail::modify_bits(words(), m_offset + l, m_offset + r, detail::range_op::clear);
         }
-        inline void set_bit_true_unsafe(const size_t& pos) const {
-            BitType mask = 1UL << (pos % WORD_BITS);
-            BitType * ptr = &m_data[pos / WORD_BITS];
-            *ptr |= mask;
+
+        void flip_range(size_t l, size_t r) const
+        {
+            check_range(l, r);
+            detail::modify_bits(words(), m_offset + l, m_offset + r, detail::range_op::flip);
         }
-        inline void qset_bit_true_6_v2(size_t pos,const size_t stride,const size_t size) const {
-                __m256i vStride = _mm256_set1_epi64x(stride);
-                __m256i vPos = _mm256_set_epi64x(pos + 3 * stride, pos + 2 * stride, pos + stride, pos);
-
-                // Loop to handle setting bits
-                int i = 0;
-                int left = size % 4;
-                int stride4limit = size - left;
-                for (; i < stride4limit; i += 4) {
-                    //pos % WORD_BITS
-                    __m256i vModPos = _mm256_rem_epi64(vPos, _mm256_set1_epi64x(WORD_BITS));
-                    //1UL << (pos % WORD_BITS)
-                    __m256i vMask = _mm256_sllv_epi64(_mm256_set1_epi64x(1UL), vModPos);
-                    //pos / WORD_BITS
-                    __m256i vIdx = _mm256_div_epi64(vPos, _mm256_set1_epi64x(WORD_BITS));
-
-                    // Load, modify, and store back values
-
-                        BitType *ptr0 = &m_data[_mm256_extract_epi64(vIdx, 0)];
-                        *ptr0 |= _mm256_extract_epi64(vMask, 0);
-                        BitType *ptr1 = &m_data[_mm256_extract_epi64(vIdx, 1)];
-                        *ptr1 |= _mm256_extract_epi64(vMask, 1);
-                        BitType *ptr2 = &m_data[_mm256_extract_epi64(vIdx, 2)];
-                        *ptr2 |= _mm256_extract_epi64(vMask, 2);
-                        BitType *ptr3 = &m_data[_mm256_extract_epi64(vIdx, 3)];
-                        *ptr3 |= _mm256_extract_epi64(vMask, 3);
-
-                    vPos = _mm256_add_epi64(vPos, vStride);
-                }
+    };
 
-                __m256i vModPos2 = _mm256_rem_epi64(vPos, _mm256_set1_epi64x(WORD_BITS));
-                __m256i vMask2 = _mm256_sllv_epi64(_mm256_set1_epi64x(1UL), vModPos2);
-                __m256i vIdx2 = _mm256_div_epi64(vPos, _mm256_set1_epi64x(WORD_BITS));
+    template<typename Allocator, std::size_t InlineBits>
+    ConstBitSpan BitVector<Allocator, InlineBits>::subspan(size_t l, size_t r) const
+    {
+        check_range(l, r);
+        return ConstBitSpan(m_data, l, r - l);
+    }
 
-                // Load, modify, and store back values
-                int j = i;
+    template<typename Allocator, std::size_t InlineBits>
+    BitSpan BitVector<Allocator, InlineBits>::subspan(size_t l, size_t r)
+    {
+        check_range(l, r);
+        return BitSpan(m_data, l, r - l);
+    }
 
-                if (j < size) {
-                    BitType *ptr = &m_data[_mm256_extract_epi64(vIdx2, 0)];
-                    *ptr |= _mm256_extract_epi64(vMask2, 0);
-                } else
-                    return;
-                ++j;
-                if (j < size) {
-                    BitType *ptr = &m_data[_mm256_extract_epi64(vIdx2, 1)];
-                    *ptr |= _mm256_extract_epi64(vMask2, 1);
-                } else
-                    return;
-                ++j;
-                if (j < size) {
-                    BitType *ptr = &m_data[_mm256_extract_epi64(vIdx2, 2)];
-                    *ptr |= _mm256_extract_epi64(vMask2, 2);
-                }
+    namespace detail
+    {
+        template<typename T>
+        struct is_bit_vector : std::false_type {};
 
+        template<typename Allocator, std::size_t InlineBits>
+        struct is_bit_vector<BitVector<Allocator, InlineBits>> : std::true_type {};
 
+        template<typename T>
+        struct is_bit_operand
+            : std::integral_constant<bool, is_bit_vector<T>::value || is_bit_expr<T>::value> {};
 
+        template<typename Allocator, std::size_t InlineBits>
+        BitVectorLeaf<allocator_alignment<Allocator>::value> as_expr(const BitVector<Allocator, InlineBits>& v)
+        {
+            return BitVectorLeaf<allocator_alignment<Allocator>::value>(v.data(), v.size());
         }
-        inline void set_bit_true_6(size_t pos, const size_t stride) {
-            //_mm_prefetch((char *) &m_data[pos + 6 * stride / WORD_BITS], _MM_HINT_T0);
-            for (int i = 0; i < 6; i++) {
-                BitType mask = 1UL << (pos % WORD_BITS);
-                BitType *ptr = &m_data[pos / WORD_BITS];
-                *ptr |= mask;
-                pos += stride;
-            }
-        }
-        void incrementUntilZero(size_t& pos){
-            // Ensure the position is within bounds
-#ifndef BITVECTOR_NO_BOUND_CHECK
-            if (pos >= m_size){
-                std::stringstream  ss;
-                ss << "BitVector index out of range" << "pos: "<< pos << " size: " << m_size << std::endl;
-                throw std::out_of_range(ss.str());
-                    return;
-            }
-#endif
-            while (pos < m_size&& pos%WORD_BITS!=0 && (*this)[pos] != 0) // Check if bit at pos is 1
-            {
-                ++pos; // Increment pos to the next bit
-            }
-            while(pos < m_size-WORD_BITS&& (*this)[pos] != 0){
-                BitType num = m_data[pos / WORD_BITS];
-                int oneCounts = _tzcnt_u64(~num);
-                if(oneCounts == WORD_BITS){
-                    pos+= oneCounts;
-                }else{
-                    pos+= oneCounts;
-                    break;
-                }
-            }
-            // Iterate through the bits starting from the given position
-            while (pos < m_size && (*this)[pos] != 0) // Check if bit at pos is 1
-            {
-                ++pos; // Increment pos to the next bit
-            }
+
+        template<typename Derived>
+        const Derived& as_expr(const BitExpr<Derived>& e)
+        {
+            return static_cast<const Derived&>(e);
         }
 
+        template<typename T>
+        using expr_t = std::decay_t<decltype(as_expr(std::declval<const T&>()))>;
 
-        void push_back(bool value)
+        template<typename Op, typename L, typename R>
+        BitBinaryExpr<Op, expr_t<L>, expr_t<R>> make_binary(const L& lhs, const R& rhs)
         {
-            if (m_size == m_capacity * WORD_BITS)
-            {
-                reserve(m_capacity ? m_capacity * WORD_BITS * 2 : WORD_BITS);
-            }
-
-            size_t word_index = m_size >> WORD_SHIFT;
-            BitType mask = static_cast<BitType>(1)
-                           << (m_size & (WORD_BITS - 1));
-            if (value)
-                m_data[word_index] |= mask;
-            else
-                m_data[word_index] &= ~mask;
-            ++m_size;
+            return BitBinaryExpr<Op, expr_t<L>, expr_t<R>>(as_expr(lhs), as_expr(rhs));
         }
+    } // namespace detail
 
-        void reserve(size_t new_capacity)
-        {
-            if (new_capacity > m_capacity * WORD_BITS)
-            {
-                size_t new_word_count = num_words(new_capacity);
+    template<typename L, typename R,
+             typename = std::enable_if_t<detail::is_bit_operand<L>::value && detail::is_bit_operand<R>::value>>
+    auto operator&(const L& lhs, const R& rhs)
+    {
+        return detail::make_binary<detail::and_op>(lhs, rhs);
+    }
 
-                BitType *new_data = m_allocator.allocate(new_word_count);
-                std::copy(m_data, m_data + m_capacity, new_data);
-                deallocate_memory();
-                m_data = new_data;
-                m_capacity = new_word_count;
-            }
-        }
+    template<typename L, typename R,
+             typename = std::enable_if_t<detail::is_bit_operand<L>::value && detail::is_bit_operand<R>::value>>
+    auto operator|(const L& lhs, const R& rhs)
+    {
+        return detail::make_binary<detail::or_op>(lhs, rhs);
+    }
 
-        void assign(size_t n, bool value)
-        {
-            if (n > m_capacity * WORD_BITS)
-            {
-                deallocate_memory();
-                m_capacity = num_words(n);
-                allocate_memory(m_capacity);
-            }
-            m_size = n;
-            std::memset(m_data, value ? ~0 : 0, m_capacity * sizeof(BitType));
-        }
+    template<typename L, typename R,
+             typename = std::enable_if_t<detail::is_bit_operand<L>::value && detail::is_bit_operand<R>::value>>
+    auto operator^(const L& lhs, const R& rhs)
+    {
+        return detail::make_binary<detail::xor_op>(lhs, rhs);
+    }
 
-        BitType *data() {
-            return m_data;
-        }
+    // lhs & ~rhs
+    template<typename L, typename R,
+             typename = std::enable_if_t<detail::is_bit_operand<L>::value && detail::is_bit_operand<R>::value>>
+    auto andnot(const L& lhs, const R& rhs)
+    {
+        return detail::make_binary<detail::andnot_op>(lhs, rhs);
+    }
 
-        size_t size() const
+    template<typename E, typename = std::enable_if_t<detail::is_bit_operand<E>::value>>
+    auto operator~(const E& expr)
+    {
+        return BitNotExpr<detail::expr_t<E>>(detail::as_expr(expr));
+    }
+
+    // Spans compare their bits, whatever their offsets.  BitVectors convert to
+    // spans, so this also compares vectors.
+    inline bool operator==(const ConstBitSpan& a, const ConstBitSpan& b)
+    {
+        return a.size() == b.size() && !(a ^ b).any();
+    }
+
+    inline bool operator!=(const ConstBitSpan& a, const ConstBitSpan& b)
+    {
+        return !(a == b);
+    }
+
+
+    // Word-at-a-time versions of count, find, fill, copy and equal for bit
+    // iterator ranges, like libstdc++'s overloads for vector<bool>.  They
+    // live in namespace bowen rather than std and are found by argument-
+    // dependent lookup: an unqualified call, or one after `using std::count;`,
+    // picks them over the std templates because their iterator parameters
+    // are more specialized.
+    namespace detail
+    {
+        inline ConstBitSpan iterator_span(const bit_iterator_base& first, std::ptrdiff_t n)
         {
-            return m_size;
+            return ConstBitSpan(first.m_ptr, first.m_offset, static_cast<std::size_t>(n));
         }
 
-        bool empty() const
+        inline std::ptrdiff_t iterator_count(const bit_iterator_base& first, const bit_iterator_base& last, bool value)
         {
-            return m_size == 0;
+            const std::ptrdiff_t n = last - first;
+            if (n <= 0)
+                return 0;
+            const std::ptrdiff_t ones = static_cast<std::ptrdiff_t>(
+                count_bits(first.m_ptr, first.m_offset, first.m_offset + static_cast<std::size_t>(n)));
+            return value ? ones : n - ones;
         }
 
-        iterator begin()
+        // Distance from first to the first bit equal to value, or
+        // last - first.
+        inline std::ptrdiff_t iterator_find(const bit_iterator_base& first, const bit_iterator_base& last, bool value)
         {
-            return iterator(m_data, 0);
+            const std::ptrdiff_t n = last - first;
+            if (n <= 0)
+                return 0;
+            const std::size_t end = first.m_offset + static_cast<std::size_t>(n);
+            const std::size_t found = value ? find_next_bit<false>(first.m_ptr, first.m_offset, end)
+                                            : find_next_bit<true>(first.m_ptr, first.m_offset, end);
+            return found == static_cast<std::size_t>(-1) ? n : static_cast<std::ptrdiff_t>(found - first.m_offset);
         }
 
-        iterator end()
+        // Copies n bits: a masked merge up to the next word boundary of the
+        // destination, whole words through the span's shift-merge loads, and
+        // a masked merge of the tail.  Each step reads its source words
+        // before it stores, so a destination before the source may overlap
+        // it, as std::copy allows.
+        inline void iterator_copy(const bit_iterator_base& first, std::ptrdiff_t count, const bit_iterator_base& d_first)
         {
-            return iterator(m_data + num_words(m_size), 0);
+            if (count <= 0)
+                return;
+            std::size_t n = static_cast<std::size_t>(count);
+            std::size_t src = first.m_offset;
+            BitType* dst = d_first.m_ptr;
+            if (d_first.m_offset) {
+                const std::size_t head = std::min<std::size_t>(n, WORD_BITS - d_first.m_offset);
+                const BitType mask = ((static_cast<BitType>(1) << head) - 1) << d_first.m_offset;
+                const BitType bits = iterator_span(first, static_cast<std::ptrdiff_t>(head)).word(0) << d_first.m_offset;
+                *dst = (*dst & ~mask) | (bits & mask);
+                src += head;
+                n -= head;
+                ++dst;
+            }
+            const ConstBitSpan span(first.m_ptr, src, n);
+            const std::size_t full = n >> WORD_SHIFT;
+            eval_kernel<alignof(BitType)>(dst, span, full);
+            if (n & (WORD_BITS - 1)) {
+                const BitType mask = tail_mask(n);
+                dst[full] = (dst[full] & ~mask) | (span.word(full) & mask);
+            }
         }
-    };
+    } // namespace detail
+
+    template<typename Allocator>
+    std::ptrdiff_t count(BitConstIterator<Allocator> first, BitConstIterator<Allocator> last, const bool& value)
+    {
+        return detail::iterator_count(first, last, value);
+    }
+
+    template<typename Allocator>
+    std::ptrdiff_t count(BitIterator<Allocator> first, BitIterator<Allocator> last, const bool& value)
+    {
+        return detail::iterator_count(first, last, value);
+    }
+
+    template<typename Allocator>
+    BitConstIterator<Allocator> find(BitConstIterator<Allocator> first, BitConstIterator<Allocator> last, const bool& value)
+    {
+        return first + detail::iterator_find(first, last, value);
+    }
+
+    template<typename Allocator>
+    BitIterator<Allocator> find(BitIterator<Allocator> first, BitIterator<Allocator> last, const bool& value)
+    {
+        return first + detail::iterator_find(first, last, value);
+    }
+
+    template<typename Allocator>
+    void fill(BitIterator<Allocator> first, BitIterator<Allocator> last, const bool& value)
+    {
+        if (first < last)
+            detail::modify_bits(first.m_ptr, first.m_offset, first.m_offset + static_cast<std::size_t>(last - first),
+                                value ? detail::range_op::set : detail::range_op::clear);
+    }
+
+    template<typename Allocator, typename OutAllocator>
+    BitIterator<OutAllocator> copy(BitConstIterator<Allocator> first, BitConstIterator<Allocator> last,
+                                   BitIterator<OutAllocator> d_first)
+    {
+        detail::iterator_copy(first, last - first, d_first);
+        return d_first + (last - first);
+    }
+
+    template<typename Allocator, typename OutAllocator>
+    BitIterator<OutAllocator> copy(BitIterator<Allocator> first, BitIterator<Allocator> last,
+                                   BitIterator<OutAllocator> d_first)
+    {
+        detail::iterator_copy(first, last - first, d_first);
+        return d_first + (last - first);
+    }
+
+    template<typename Allocator, typename Allocator2>
+    bool equal(BitConstIterator<Allocator> first1, BitConstIterator<Allocator> last1, BitConstIterator<Allocator2> first2)
+    {
+        return detail::iterator_span(first1, last1 - first1) == detail::iterator_span(first2, last1 - first1);
+    }
+
+    template<typename Allocator, typename Allocator2>
+    bool equal(BitConstIterator<Allocator> first1, BitConstIterator<Allocator> last1, BitIterator<Allocator2> first2)
+    {
+        return detail::iterator_span(first1, last1 - first1) == detail::iterator_span(first2, last1 - first1);
+    }
+
+    template<typename Allocator, typename Allocator2>
+    bool equal(BitIterator<Allocator> first1, BitIterator<Allocator> last1, BitConstIterator<Allocator2> first2)
+    {
+        return detail::iterator_span(first1, last1 - first1) == detail::iterator_span(first2, last1 - first1);
+    }
+
+    template<typename Allocator, typename Allocator2>
+    bool equal(BitIterator<Allocator> first1, BitIterator<Allocator> last1, BitIterator<Allocator2> first2)
+    {
+        return detail::iterator_span(first1, last1 - first1) == detail::iterator_span(first2, last1 - first1);
+    }
 
 } // namespace bowen
 
@@ -1,5 +1,20 @@
+#include "arena_allocator.hpp"
+#include "atomic_bitvector.hpp"
+#include "bit_array.hpp"
 #include "bitvector.hpp"
+#include "ewah.hpp"
+#include "hugepage_allocator.hpp"
+#include "mapped_bitvector.hpp"
+#include "parallel.hpp"
+#include "prime_sieve.hpp"
+#include "rank_select.hpp"
+#include "roaring.hpp"
+#include "serialize.hpp"
 #include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <bitset>
+#include <random>
 #include <vector>
 
 #ifndef BITVECTOR_BENCHMARK_MIN_TIME
@@ -42,6 +57,20 @@ static void BM_Bowen_PushBack(benchmark::State& state) {
   }
 }
 
+static void BM_Bowen_AppendBools(benchmark::State& state) {
+  size_t n = state.range(0);
+  const size_t start = state.range(1);
+  std::vector<uint8_t> flags(n);
+  for (size_t i = 0; i < n; ++i)
+    flags[i] = static_cast<uint8_t>(i & 1);
+  for (auto _ : state) {
+    BitVector<> bv(start);
+    bv.reserve(start + n);
+    bv.append_bools(flags.data(), n);
+    benchmark::ClobberMemory();
+  }
+}
+
 static void BM_Std_PushBack(benchmark::State& state) {
   size_t n = state.range(0);
   for (auto _ : state) {
@@ -191,21 +220,1356 @@ static void BM_Std_IncrementUntilZero(benchmark::State& state) {
   }
 }
 
-BENCHMARK(BM_Bowen_Set)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_Set)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Bowen_PushBack)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_PushBack)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Bowen_Access)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_Access)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Bowen_SetBit)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_SetBit)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Bowen_SetBitTrueUnsafe)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_SetBitTrueUnsafe)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Bowen_SetBitTrue6)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_SetBitTrue6)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Bowen_QSetBitTrue6V2)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_QSetBitTrue6)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Bowen_IncrementUntilZero)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
-BENCHMARK(BM_Std_IncrementUntilZero)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+static void BM_Bowen_And(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a(n), b(n);
+  for (size_t i=0;i<n;++i) {
+    a[i] = static_cast<bool>(i & 1);
+    b[i] = static_cast<bool>(i & 2);
+  }
+  for (auto _ : state) {
+    a &= b;
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8) * 2);
+}
+
+static void BM_Std_And(benchmark::State& state) {
+  size_t n = state.range(0);
+  std::vector<bool> a(n), b(n);
+  for (size_t i=0;i<n;++i) {
+    a[i] = static_cast<bool>(i & 1);
+    b[i] = static_cast<bool>(i & 2);
+  }
+  for (auto _ : state) {
+    for (size_t i=0;i<n;++i) {
+      a[i] = a[i] & b[i];
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8) * 2);
+}
+
+static void BM_Bowen_OrOutOfPlace(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a(n), b(n);
+  for (size_t i=0;i<n;++i) {
+    a[i] = static_cast<bool>(i & 1);
+    b[i] = static_cast<bool>(i & 2);
+  }
+  for (auto _ : state) {
+    BitVector<> c = a | b;
+    benchmark::DoNotOptimize(c.data());
+  }
+}
+
+static void BM_Std_OrOutOfPlace(benchmark::State& state) {
+  size_t n = state.range(0);
+  std::vector<bool> a(n), b(n);
+  for (size_t i=0;i<n;++i) {
+    a[i] = static_cast<bool>(i & 1);
+    b[i] = static_cast<bool>(i & 2);
+  }
+  for (auto _ : state) {
+    std::vector<bool> c(n);
+    for (size_t i=0;i<n;++i) {
+      c[i] = a[i] | b[i];
+    }
+    benchmark::ClobberMemory();
+  }
+}
+
+static void BM_Bowen_Flip(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType>> bv(n);
+  for (auto _ : state) {
+    bv.flip();
+    benchmark::ClobberMemory();
+  }
+}
+
+static void BM_Std_Flip(benchmark::State& state) {
+  size_t n = state.range(0);
+  std::vector<bool> bv(n);
+  for (auto _ : state) {
+    bv.flip();
+    benchmark::ClobberMemory();
+  }
+}
+
+static void BM_Bowen_Count(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType>> bv(n);
+  for (size_t i=0;i<n;i+=3) bv.set_bit(i, true);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bv.count());
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Std_Count(benchmark::State& state) {
+  size_t n = state.range(0);
+  std::vector<bool> bv(n);
+  for (size_t i=0;i<n;i+=3) bv[i] = true;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::count(bv.begin(), bv.end(), true));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_AndCount(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType>> a(n), b(n);
+  for (size_t i=0;i<n;i+=3) a.set_bit(i, true);
+  for (size_t i=0;i<n;i+=5) b.set_bit(i, true);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(and_count(a, b));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8) * 2);
+}
+
+static void BM_Bowen_AndThenCount(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType>> a(n), b(n);
+  for (size_t i=0;i<n;i+=3) a.set_bit(i, true);
+  for (size_t i=0;i<n;i+=5) b.set_bit(i, true);
+  for (auto _ : state) {
+    BitVector<bowen::MMAllocator<bowen::BitType>> tmp = a & b;
+    benchmark::DoNotOptimize(tmp.count());
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8) * 2);
+}
+
+static std::vector<size_t> random_queries(size_t limit, size_t count) {
+  std::mt19937_64 rng(1);
+  std::vector<size_t> queries(count);
+  for (auto& q : queries) q = rng() % limit;
+  return queries;
+}
+
+static void BM_Bowen_Rank1(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType, 64>> bv(n);
+  for (size_t i=0;i<n;i+=3) bv.set_bit(i, true);
+  bowen::RankSelect rs(bv);
+  auto queries = random_queries(n, 4096);
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (size_t q : queries) sum += rs.rank1(q);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+static void BM_Bowen_Select1(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType, 64>> bv(n);
+  for (size_t i=0;i<n;i+=3) bv.set_bit(i, true);
+  bowen::RankSelect rs(bv);
+  auto queries = random_queries(rs.ones(), 4096);
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (size_t q : queries) sum += rs.select1(q);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+static void BM_Bowen_Select0(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType, 64>> bv(n);
+  for (size_t i=0;i<n;i+=3) bv.set_bit(i, true);
+  bowen::RankSelect rs(bv);
+  auto queries = random_queries(rs.zeros(), 4096);
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (size_t q : queries) sum += rs.select0(q);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+// Rank answered by counting from the start of the vector on every query.
+static void BM_Bowen_RankLinearCount(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<bowen::MMAllocator<bowen::BitType, 64>> bv(n);
+  for (size_t i=0;i<n;i+=3) bv.set_bit(i, true);
+  auto queries = random_queries(n, 64);
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (size_t q : queries) sum += bv.count(0, q);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+// Walks every set bit of a sparse bitmap (one bit per 64 KiB of bits).
+static void BM_Bowen_FindNextOneSparse(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv(n);
+  for (size_t i=12345;i<n;i+=(1<<19)) bv.set_bit(i, true);
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (size_t p = bv.find_first_one(); p != BitVector<>::npos; p = bv.find_next_one(p + 1)) ++hits;
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Std_FindNextOneSparse(benchmark::State& state) {
+  size_t n = state.range(0);
+  std::vector<bool> bv(n);
+  for (size_t i=12345;i<n;i+=(1<<19)) bv[i] = true;
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (auto it = std::find(bv.begin(), bv.end(), true); it != bv.end(); it = std::find(it + 1, bv.end(), true)) ++hits;
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_FindPrevZeroDense(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv(n, true);
+  bv.set_bit(3, false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bv.find_prev_zero(n));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+// state.range(1) is the density of set bits in tenths of a percent.
+static BitVector<> random_bits(size_t n, size_t per_mille) {
+  std::mt19937_64 rng(2);
+  BitVector<> bv(n);
+  for (size_t i=0;i<n;++i) bv.set_bit(i, rng() % 1000 < per_mille);
+  return bv;
+}
+
+static void BM_Bowen_ExtractOnes(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv = random_bits(n, state.range(1));
+  std::vector<uint32_t> out(bv.count());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bv.extract_ones(out.data()));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * out.size());
+}
+
+static void BM_Bowen_ExtractOnesIterator(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv = random_bits(n, state.range(1));
+  std::vector<uint32_t> out(bv.count());
+  for (auto _ : state) {
+    size_t k = 0;
+    auto it = bv.begin();
+    for (size_t i=0;i<n;++i, ++it) {
+      if (*it) out[k++] = static_cast<uint32_t>(i);
+    }
+    benchmark::DoNotOptimize(k);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * out.size());
+}
+
+// Sets a range of state.range(0) bits starting at an unaligned offset.
+static void BM_Bowen_SetRange(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv(n + 64);
+  for (auto _ : state) {
+    bv.set_range(3, 3 + n);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_SetRangePerBit(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv(n + 64);
+  for (auto _ : state) {
+    for (size_t i=3;i<3+n;++i) bv.set_bit(i, true);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_FlipRange(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv(n + 64);
+  for (auto _ : state) {
+    bv.flip_range(3, 3 + n);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_NoneRange(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv(n + 64);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bv.none(3, 3 + n));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_ShiftLeft(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv = random_bits(n, 500);
+  for (auto _ : state) {
+    bv.shift_left(state.range(1));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_ShiftRightInto(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv = random_bits(n, 500);
+  BitVector<> dst(n);
+  for (auto _ : state) {
+    bv.shift_right_into(dst, state.range(1));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_RotateLeftInto(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bv = random_bits(n, 500);
+  BitVector<> dst(n);
+  for (auto _ : state) {
+    bv.rotate_left_into(dst, state.range(1));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+// Shift rebuilt bit by bit, the only option before shift_left existed.
+static void BM_Bowen_ShiftLeftPerBit(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t k = state.range(1);
+  BitVector<> bv = random_bits(n, 500);
+  BitVector<> dst(n);
+  for (auto _ : state) {
+    for (size_t i=0;i<k;++i) dst.set_bit(i, false);
+    for (size_t i=k;i<n;++i) dst.set_bit(i, bv[i - k]);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+// (a & b) | (c & ~d) evaluated one operator at a time with temporaries:
+// every step streams its operands and writes a full intermediate vector.
+static void BM_Bowen_ExprEager(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a = random_bits(n, 500), b = random_bits(n, 300), c = random_bits(n, 200), d = random_bits(n, 700);
+  BitVector<> dst(n);
+  for (auto _ : state) {
+    BitVector<> ab(a);
+    ab &= b;
+    BitVector<> not_d(d);
+    not_d.flip();
+    not_d &= c;
+    ab |= not_d;
+    dst = ab;
+    benchmark::ClobberMemory();
+  }
+  // reads + writes: copy a (2), &= b (3), copy d (2), flip (2), &= c (3), |= (3), copy out (2)
+  state.counters["bytes_touched"] = benchmark::Counter(17.0 * (n / 8), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// The same expression as a lazy tree evaluated in one pass into dst.
+static void BM_Bowen_ExprFused(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a = random_bits(n, 500), b = random_bits(n, 300), c = random_bits(n, 200), d = random_bits(n, 700);
+  BitVector<> dst(n);
+  for (auto _ : state) {
+    dst = (a & b) | (c & ~d);
+    benchmark::ClobberMemory();
+  }
+  // four operand reads + one write
+  state.counters["bytes_touched"] = benchmark::Counter(5.0 * (n / 8), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Terminal count over the expression: four reads, no writes.
+static void BM_Bowen_ExprFusedCount(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a = random_bits(n, 500), b = random_bits(n, 300), c = random_bits(n, 200), d = random_bits(n, 700);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(((a & b) | (c & ~d)).count());
+  }
+  state.counters["bytes_touched"] = benchmark::Counter(4.0 * (n / 8), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void BM_Bowen_SetStride(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t stride = state.range(1);
+  size_t count = (n - 1) / stride + 1;
+  BitVector<> bv(n);
+  for (auto _ : state) {
+    bv.set_stride(0, stride, count);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_Bowen_SetStridePerBit(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t stride = state.range(1);
+  size_t count = (n - 1) / stride + 1;
+  BitVector<> bv(n);
+  for (auto _ : state) {
+    for (size_t pos=0;pos<n;pos+=stride) bv.set_bit_true_unsafe(pos);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_Std_SetStride(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t stride = state.range(1);
+  size_t count = (n - 1) / stride + 1;
+  std::vector<bool> bv(n);
+  for (auto _ : state) {
+    for (size_t pos=0;pos<n;pos+=stride) bv[pos] = true;
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// state.range(1) is the number of sieving threads; 0 means one per core.
+static void BM_Bowen_PrimeCount(benchmark::State& state) {
+  uint64_t limit = state.range(0);
+  unsigned threads = state.range(1) ? static_cast<unsigned>(state.range(1)) : std::thread::hardware_concurrency();
+  bowen::PrimeSieve sieve(limit);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sieve.count(threads));
+  }
+  state.counters["threads"] = threads;
+}
+
+static void BM_Bowen_PrimeIterate(benchmark::State& state) {
+  uint64_t limit = state.range(0);
+  bowen::PrimeSieve sieve(limit);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (uint64_t p : sieve) sum += p;
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Scaling of the parallel bulk operations: range(0) bits, range(1) threads.
+static void BM_Bowen_ParallelAssign(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::ThreadPool pool(static_cast<unsigned>(state.range(1)));
+  bowen::ParallelPolicy par(pool);
+  BitVector<> bv(n);
+  bool value = false;
+  for (auto _ : state) {
+    bv.assign(par, n, value);
+    value = !value;
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_ParallelCopy(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::ThreadPool pool(static_cast<unsigned>(state.range(1)));
+  bowen::ParallelPolicy par(pool);
+  BitVector<> src(n, true), dst(n);
+  for (auto _ : state) {
+    dst.assign(par, src);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * (n / 8));
+}
+
+static void BM_Bowen_ParallelAnd(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::ThreadPool pool(static_cast<unsigned>(state.range(1)));
+  bowen::ParallelPolicy par(pool);
+  BitVector<> a(n, true), b(n, true);
+  for (auto _ : state) {
+    a.and_assign(par, b);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * 3 * (n / 8));
+}
+
+static void BM_Bowen_ParallelCount(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::ThreadPool pool(static_cast<unsigned>(state.range(1)));
+  bowen::ParallelPolicy par(pool);
+  BitVector<> bv(n, true);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bv.count(par));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_ParallelFindFirst(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::ThreadPool pool(static_cast<unsigned>(state.range(1)));
+  bowen::ParallelPolicy par(pool);
+  BitVector<> bv(n);
+  bv.set_bit(n - 1, true);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bv.find_first_one(par));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+// Contention on a bitmap shared by all benchmark threads: range(0) bits,
+// each thread writes random positions of its own.
+static bowen::AtomicBitVector* shared_bits = nullptr;
+
+static std::vector<size_t> thread_positions(const benchmark::State& state, size_t limit) {
+  std::mt19937_64 rng(state.thread_index() + 1);
+  std::vector<size_t> positions(4096);
+  for (auto& p : positions) p = rng() % limit;
+  return positions;
+}
+
+static void BM_Bowen_AtomicSet(benchmark::State& state) {
+  size_t n = state.range(0);
+  if (state.thread_index() == 0) shared_bits = new bowen::AtomicBitVector(n);
+  auto positions = thread_positions(state, n);
+  for (auto _ : state) {
+    for (size_t p : positions) shared_bits->set(p);
+  }
+  if (state.thread_index() == 0) delete shared_bits;
+  state.SetItemsProcessed(state.iterations() * positions.size());
+}
+
+static void BM_Bowen_AtomicTestAndSet(benchmark::State& state) {
+  size_t n = state.range(0);
+  if (state.thread_index() == 0) shared_bits = new bowen::AtomicBitVector(n);
+  auto positions = thread_positions(state, n);
+  for (auto _ : state) {
+    for (size_t p : positions) benchmark::DoNotOptimize(shared_bits->test_and_set(p));
+  }
+  if (state.thread_index() == 0) delete shared_bits;
+  state.SetItemsProcessed(state.iterations() * positions.size());
+}
+
+static void BM_Bowen_AtomicFetchOrWord(benchmark::State& state) {
+  size_t n = state.range(0);
+  if (state.thread_index() == 0) shared_bits = new bowen::AtomicBitVector(n);
+  auto positions = thread_positions(state, n);
+  for (auto _ : state) {
+    for (size_t p : positions)
+      benchmark::DoNotOptimize(shared_bits->fetch_or_word(p >> bowen::WORD_SHIFT, static_cast<bowen::BitType>(1) << (p & 63)));
+  }
+  if (state.thread_index() == 0) delete shared_bits;
+  state.SetItemsProcessed(state.iterations() * positions.size());
+}
+
+// Relaxed test() against a plain BitVector read of the same positions.
+static void BM_Bowen_AtomicTest(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::AtomicBitVector bits(random_bits(n, 500));
+  auto positions = random_queries(n, 4096);
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (size_t p : positions) hits += bits.test(p);
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * positions.size());
+}
+
+static void BM_Bowen_PlainTest(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bits = random_bits(n, 500);
+  auto positions = random_queries(n, 4096);
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (size_t p : positions) hits += bits[p];
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * positions.size());
+}
+
+// Compressed vs flat bitmaps at range(1) set bits per million.
+static BitVector<> random_bits_ppm(size_t n, size_t ppm, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  BitVector<> bv(n);
+  for (size_t i=0;i<n;++i) if (rng() % 1000000 < ppm) bv.set_bit_true_unsafe(i);
+  return bv;
+}
+
+static void BM_Bowen_RoaringAnd(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::RoaringBitmap a(random_bits_ppm(n, state.range(1), 3)), b(random_bits_ppm(n, state.range(1), 4));
+  for (auto _ : state) {
+    bowen::RoaringBitmap c = a & b;
+    benchmark::DoNotOptimize(c.cardinality());
+  }
+  state.counters["bytes"] = a.memory_bytes();
+  state.counters["flat_bytes"] = n / 8;
+}
+
+static void BM_Bowen_RoaringOr(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::RoaringBitmap a(random_bits_ppm(n, state.range(1), 3)), b(random_bits_ppm(n, state.range(1), 4));
+  for (auto _ : state) {
+    bowen::RoaringBitmap c = a | b;
+    benchmark::DoNotOptimize(c.cardinality());
+  }
+  state.counters["bytes"] = a.memory_bytes();
+  state.counters["flat_bytes"] = n / 8;
+}
+
+static void BM_Bowen_FlatAnd(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a = random_bits_ppm(n, state.range(1), 3), b = random_bits_ppm(n, state.range(1), 4), c(n);
+  for (auto _ : state) {
+    c = a & b;
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.counters["bytes"] = n / 8;
+}
+
+static void BM_Bowen_FlatOr(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a = random_bits_ppm(n, state.range(1), 3), b = random_bits_ppm(n, state.range(1), 4), c(n);
+  for (auto _ : state) {
+    c = a | b;
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.counters["bytes"] = n / 8;
+}
+
+// Run-heavy columns: alternating runs of 1..2*range(1) bits with one dirty
+// word per ~100.  bytes_touched counts both inputs plus the result.
+static BitVector<> run_heavy_bits(size_t n, size_t avg_run, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  BitVector<> bv(n);
+  bool value = false;
+  for (size_t i = 0; i < n;) {
+    size_t end = std::min(n, i + 1 + rng() % (2 * avg_run));
+    if (value) bv.set_range(i, end);
+    i = end;
+    value = !value;
+  }
+  for (size_t k = 0; k < n / 6400; ++k) bv.set_bit_true_unsafe(rng() % n);
+  return bv;
+}
+
+static void BM_Bowen_EwahAnd(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::EwahBitmap a(run_heavy_bits(n, state.range(1), 5)), b(run_heavy_bits(n, state.range(1), 6));
+  size_t result_bytes = 0;
+  for (auto _ : state) {
+    bowen::EwahBitmap c = a & b;
+    result_bytes = c.compressed_bytes();
+    benchmark::DoNotOptimize(result_bytes);
+  }
+  state.counters["bytes_touched"] = a.compressed_bytes() + b.compressed_bytes() + result_bytes;
+}
+
+static void BM_Bowen_EwahOr(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::EwahBitmap a(run_heavy_bits(n, state.range(1), 5)), b(run_heavy_bits(n, state.range(1), 6));
+  size_t result_bytes = 0;
+  for (auto _ : state) {
+    bowen::EwahBitmap c = a | b;
+    result_bytes = c.compressed_bytes();
+    benchmark::DoNotOptimize(result_bytes);
+  }
+  state.counters["bytes_touched"] = a.compressed_bytes() + b.compressed_bytes() + result_bytes;
+}
+
+static void BM_Bowen_EwahCount(benchmark::State& state) {
+  size_t n = state.range(0);
+  bowen::EwahBitmap a(run_heavy_bits(n, state.range(1), 5));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a.count());
+  }
+  state.counters["bytes_touched"] = a.compressed_bytes();
+}
+
+static void BM_Bowen_FlatRunAnd(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> a = run_heavy_bits(n, state.range(1), 5), b = run_heavy_bits(n, state.range(1), 6), c(n);
+  for (auto _ : state) {
+    c = a & b;
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.counters["bytes_touched"] = 3 * (n / 8);
+}
+
+// Bit vector file of n random bits, written once per process.
+static const std::string& mapped_bench_file(size_t n) {
+  static std::string path;
+  static size_t written = 0;
+  if (written != n) {
+    path = "/tmp/bitvector_benchmark_" + std::to_string(n) + ".bv";
+    bowen::MappedBitVector bits = bowen::create_mapped_bitvector(path, n);
+    std::mt19937_64 rng(7);
+    for (size_t i = 0; i < (n + 63) / 64; ++i)
+      bits.data()[i] = rng();
+    bowen::sync(bits);
+    written = n;
+  }
+  return path;
+}
+
+// Startup cost of mapping a file: no bits are read.
+static void BM_Bowen_MappedOpen(benchmark::State& state) {
+  const std::string& path = mapped_bench_file(state.range(0));
+  for (auto _ : state) {
+    const bowen::MappedBitVector bits = bowen::open_mapped_bitvector(path, bowen::MapMode::ReadOnly);
+    benchmark::DoNotOptimize(bits.data());
+  }
+}
+
+// Mapping plus one full pass, which faults every page in.
+static void BM_Bowen_MappedOpenCount(benchmark::State& state) {
+  const std::string& path = mapped_bench_file(state.range(0));
+  for (auto _ : state) {
+    const bowen::MappedBitVector bits = bowen::open_mapped_bitvector(path, bowen::MapMode::ReadOnly);
+    bowen::advise(bits, bowen::MapAccess::Sequential);
+    benchmark::DoNotOptimize(bits.count());
+  }
+}
+
+// Loading the same file into an ordinary BitVector with read().
+static BitVector<> read_bench_file(const std::string& path, size_t n) {
+  BitVector<> bits(n);
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  char* dst = reinterpret_cast<char*>(bits.data());
+  size_t left = (n + 63) / 64 * sizeof(bowen::BitType);
+  off_t offset = bowen::MappedFile::HEADER_BYTES;
+  while (left) {
+    const ssize_t got = ::pread(fd, dst, left, offset);
+    if (got <= 0)
+      break;
+    dst += got;
+    offset += got;
+    left -= got;
+  }
+  ::close(fd);
+  return bits;
+}
+
+static void BM_Bowen_ReadLoad(benchmark::State& state) {
+  size_t n = state.range(0);
+  const std::string& path = mapped_bench_file(n);
+  for (auto _ : state) {
+    BitVector<> bits = read_bench_file(path, n);
+    benchmark::DoNotOptimize(bits.data());
+  }
+}
+
+static void BM_Bowen_ReadLoadCount(benchmark::State& state) {
+  size_t n = state.range(0);
+  const std::string& path = mapped_bench_file(n);
+  for (auto _ : state) {
+    BitVector<> bits = read_bench_file(path, n);
+    benchmark::DoNotOptimize(bits.count());
+  }
+}
+
+static void BM_Bowen_Crc32c(benchmark::State& state) {
+  size_t n = state.range(0);
+  std::vector<unsigned char> buf(n);
+  std::mt19937_64 rng(9);
+  for (auto& b : buf)
+    b = static_cast<unsigned char>(rng());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bowen::crc32c(buf.data(), n));
+  }
+  state.SetBytesProcessed(state.iterations() * n);
+}
+
+// Serialized form of n random bits with popcount and rank blocks, held in
+// a word-aligned buffer.
+static std::vector<uint64_t> serialized_bench_bits(size_t n) {
+  const std::string path = "/tmp/bitvector_benchmark_serialized.bin";
+  BitVector<> bits(n);
+  std::mt19937_64 rng(11);
+  for (size_t i = 0; i < (n + 63) / 64; ++i)
+    bits.data()[i] = rng();
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  bowen::save(fd, bits, bowen::SerialFormat::POPCOUNT | bowen::SerialFormat::RANK);
+  const off_t bytes = ::lseek(fd, 0, SEEK_END);
+  std::vector<uint64_t> buf(bytes / sizeof(uint64_t));
+  ::pread(fd, buf.data(), bytes, 0);
+  ::close(fd);
+  ::unlink(path.c_str());
+  return buf;
+}
+
+static void BM_Bowen_Save(benchmark::State& state) {
+  size_t n = state.range(0);
+  BitVector<> bits(n, true);
+  const int fd = ::open("/dev/null", O_WRONLY);
+  for (auto _ : state) {
+    bowen::save(fd, bits);
+  }
+  ::close(fd);
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_LoadView(benchmark::State& state) {
+  std::vector<uint64_t> buf = serialized_bench_bits(state.range(0));
+  for (auto _ : state) {
+    bowen::BitVectorView view = bowen::load_view(buf.data(), buf.size() * sizeof(uint64_t), state.range(1) != 0);
+    benchmark::DoNotOptimize(view.count());
+  }
+}
+
+// Spans of n bits starting `offset` bits into a vector of random bits.
+static void BM_Bowen_SpanCount(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64);
+  std::mt19937_64 rng(13);
+  for (size_t i = 0; i < (n + 64) / 64; ++i)
+    bv.data()[i] = rng();
+  const BitVector<>& cbv = bv;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cbv.subspan(offset, offset + n).count());
+  }
+}
+
+static void BM_Bowen_SpanCopy(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64), out(n);
+  std::mt19937_64 rng(13);
+  for (size_t i = 0; i < (n + 64) / 64; ++i)
+    bv.data()[i] = rng();
+  const BitVector<>& cbv = bv;
+  for (auto _ : state) {
+    out = cbv.subspan(offset, offset + n);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_SpanEqual(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64);
+  std::mt19937_64 rng(13);
+  for (size_t i = 0; i < (n + 64) / 64; ++i)
+    bv.data()[i] = rng();
+  const BitVector<> copy(bv.subspan(offset, offset + n));
+  const BitVector<>& cbv = bv;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cbv.subspan(offset, offset + n) == copy);
+  }
+}
+
+// Iterator algorithms: bowen's word-at-a-time overloads against libstdc++'s
+// vector<bool> ones.  state.range(1) is the bit offset of the source range.
+static void BM_Bowen_IterCount(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64);
+  for (size_t i=0;i<n;i+=3) bv.set_bit(i, true);
+  const BitVector<>& cbv = bv;
+  for (auto _ : state) {
+    using std::count;
+    benchmark::DoNotOptimize(count(cbv.begin() + offset, cbv.begin() + offset + n, true));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Std_IterCount(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  std::vector<bool> bv(n + 64);
+  for (size_t i=0;i<n;i+=3) bv[i] = true;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::count(bv.begin() + offset, bv.begin() + offset + n, true));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_IterFind(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64);
+  bv.set_bit(offset + n - 1, true);
+  for (auto _ : state) {
+    using std::find;
+    benchmark::DoNotOptimize(find(bv.begin() + offset, bv.begin() + offset + n, true));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Std_IterFind(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  std::vector<bool> bv(n + 64);
+  bv[offset + n - 1] = true;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::find(bv.begin() + offset, bv.begin() + offset + n, true));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_IterFill(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64);
+  bool value = false;
+  for (auto _ : state) {
+    using std::fill;
+    fill(bv.begin() + offset, bv.begin() + offset + n, value = !value);
+    benchmark::DoNotOptimize(bv.data());
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Std_IterFill(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  std::vector<bool> bv(n + 64);
+  bool value = false;
+  for (auto _ : state) {
+    std::fill(bv.begin() + offset, bv.begin() + offset + n, value = !value);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_IterCopy(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64), out(n);
+  std::mt19937_64 rng(18);
+  for (size_t i = 0; i < (n + 64) / 64; ++i)
+    bv.data()[i] = rng();
+  const BitVector<>& cbv = bv;
+  for (auto _ : state) {
+    using std::copy;
+    benchmark::DoNotOptimize(copy(cbv.begin() + offset, cbv.begin() + offset + n, out.begin()));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Std_IterCopy(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  std::vector<bool> bv(n + 64), out(n);
+  std::mt19937_64 rng(18);
+  for (size_t i = 0; i < n + 64; ++i)
+    bv[i] = rng() & 1;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::copy(bv.cbegin() + offset, bv.cbegin() + offset + n, out.begin()));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Bowen_IterEqual(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  BitVector<> bv(n + 64), other(n);
+  std::mt19937_64 rng(18);
+  for (size_t i = 0; i < (n + 64) / 64; ++i)
+    bv.data()[i] = rng();
+  std::copy(bv.begin() + offset, bv.begin() + offset + n, other.begin());
+  const BitVector<>& cbv = bv;
+  for (auto _ : state) {
+    using std::equal;
+    benchmark::DoNotOptimize(equal(cbv.begin() + offset, cbv.begin() + offset + n, other.cbegin()));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+static void BM_Std_IterEqual(benchmark::State& state) {
+  size_t n = state.range(0), offset = state.range(1);
+  std::vector<bool> bv(n + 64), other(n);
+  std::mt19937_64 rng(18);
+  for (size_t i = 0; i < n + 64; ++i)
+    bv[i] = rng() & 1;
+  std::copy(bv.begin() + offset, bv.begin() + offset + n, other.begin());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::equal(bv.cbegin() + offset, bv.cbegin() + offset + n, other.cbegin()));
+  }
+  state.SetBytesProcessed(state.iterations() * (n / 8));
+}
+
+// Shuffling swaps vectors through moves; nothing of the 1M-bit buffers is
+// copied.  state.range(0) is the number of vectors.
+static void BM_Bowen_ShuffleVectors(benchmark::State& state) {
+  size_t count = state.range(0);
+  std::vector<BitVector<>> vectors;
+  for (size_t i = 0; i < count; ++i)
+    vectors.emplace_back(1 << 20, (i & 1) != 0);
+  std::mt19937_64 rng(19);
+  for (auto _ : state) {
+    std::shuffle(vectors.begin(), vectors.end(), rng);
+    benchmark::DoNotOptimize(vectors.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Many short vectors: 200-bit masks held inline (SmallBitVector<256>) or
+// each in its own heap block (BitVector<>).  state.range(0) is the number
+// of vectors.
+template<typename Vector>
+static void small_masks_construct(benchmark::State& state) {
+  size_t count = state.range(0);
+  for (auto _ : state) {
+    std::vector<Vector> masks;
+    masks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      masks.emplace_back(200);
+      masks.back().set_bit(i % 200, true);
+    }
+    benchmark::DoNotOptimize(masks.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template<typename Vector>
+static void small_masks_access(benchmark::State& state) {
+  size_t count = state.range(0);
+  std::vector<Vector> masks;
+  masks.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    masks.emplace_back(200);
+    masks.back().set_bit(i % 200, true);
+  }
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (size_t i = 0; i < count; ++i) {
+      const size_t j = (i * 2654435761u) % count; // rows in scattered order
+      hits += masks[j][(i * 7) % 200];
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_Bowen_SmallConstruct(benchmark::State& state) {
+  small_masks_construct<bowen::SmallBitVector<256>>(state);
+}
+
+static void BM_Bowen_HeapConstruct(benchmark::State& state) {
+  small_masks_construct<BitVector<>>(state);
+}
+
+static void BM_Bowen_SmallAccess(benchmark::State& state) {
+  small_masks_access<bowen::SmallBitVector<256>>(state);
+}
+
+static void BM_Bowen_HeapAccess(benchmark::State& state) {
+  small_masks_access<BitVector<>>(state);
+}
+
+// Compile-time sized BitArray<N> against std::bitset<N>.  DoNotOptimize on
+// the operands keeps the compiler from folding the loop body away.
+template<typename Bits>
+static void fill_random(Bits& bits, size_t n, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  for (size_t i = 0; i < n; ++i)
+    bits[i] = (rng() & 1) != 0;
+}
+
+template<size_t N>
+static void BM_Bowen_ArrayAndCount(benchmark::State& state) {
+  bowen::BitArray<N> a, b;
+  fill_random(a, N, 21);
+  fill_random(b, N, 22);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+    benchmark::DoNotOptimize((a & b).count());
+  }
+}
+
+template<size_t N>
+static void BM_Std_BitsetAndCount(benchmark::State& state) {
+  std::bitset<N> a, b;
+  fill_random(a, N, 21);
+  fill_random(b, N, 22);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+    benchmark::DoNotOptimize((a & b).count());
+  }
+}
+
+template<size_t N>
+static void BM_Bowen_ArrayOrAssign(benchmark::State& state) {
+  bowen::BitArray<N> a, b;
+  fill_random(a, N, 21);
+  fill_random(b, N, 22);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(b);
+    a |= b;
+    benchmark::DoNotOptimize(a);
+  }
+}
+
+template<size_t N>
+static void BM_Std_BitsetOrAssign(benchmark::State& state) {
+  std::bitset<N> a, b;
+  fill_random(a, N, 21);
+  fill_random(b, N, 22);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(b);
+    a |= b;
+    benchmark::DoNotOptimize(a);
+  }
+}
+
+// Only the last bit is set, so the search crosses every word.
+template<size_t N>
+static void BM_Bowen_ArrayFindFirst(benchmark::State& state) {
+  bowen::BitArray<N> a;
+  a.set_bit(N - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(a.find_first_one());
+  }
+}
+
+#if defined(__GLIBCXX__)
+template<size_t N>
+static void BM_Std_BitsetFindFirst(benchmark::State& state) {
+  std::bitset<N> a;
+  a.set(N - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(a._Find_first());
+  }
+}
+#endif
+
+// A query-like loop: every step builds two temporaries from the query's
+// operands, counts and drops them, and the query ends after 64 steps.
+// state.range(0) is the vector length in bits.
+template<typename Alloc, typename EndQuery>
+static void query_temporaries(benchmark::State& state, EndQuery end_query) {
+  size_t n = state.range(0);
+  BitVector<> a(n), b(n), c(n);
+  std::mt19937_64 rng(22);
+  for (size_t i = 0; i < (n + 63) / 64; ++i) {
+    a.data()[i] = rng();
+    b.data()[i] = rng();
+    c.data()[i] = rng();
+  }
+  for (auto _ : state) {
+    size_t total = 0;
+    for (int step = 0; step < 64; ++step) {
+      BitVector<Alloc> both = a & b;
+      BitVector<Alloc> any = both | c;
+      total += any.count();
+    }
+    end_query();
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * 128);
+}
+
+static void BM_Std_QueryTemporaries(benchmark::State& state) {
+  query_temporaries<std::allocator<bowen::BitType>>(state, [] {});
+}
+
+static void BM_Bowen_MMQueryTemporaries(benchmark::State& state) {
+  query_temporaries<bowen::MMAllocator<bowen::BitType>>(state, [] {});
+}
+
+static void BM_Bowen_ArenaQueryTemporaries(benchmark::State& state) {
+  query_temporaries<bowen::ArenaAllocator<bowen::BitType>>(state, [] { bowen::BitArena::local().reset(); });
+}
+
+template<typename Vector>
+static void random_access(benchmark::State& state, const Vector& bits) {
+  const size_t n = bits.size();
+  uint64_t x = 88172645463325252ull;
+  for (auto _ : state) {
+    size_t total = 0;
+    for (int i = 0; i < (1 << 20); ++i) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      total += bits[static_cast<size_t>((static_cast<unsigned __int128>(x) * n) >> 64)];
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * (1 << 20));
+}
+
+static void BM_Bowen_RandomAccess(benchmark::State& state) {
+  BitVector<> bits(state.range(0), true);
+  random_access(state, bits);
+}
+
+static void BM_Bowen_HugePageRandomAccess(benchmark::State& state) {
+  const bowen::HugePageBitVector bits = bowen::make_hugepage_bitvector(state.range(0), true);
+  random_access(state, bits);
+}
+
+static void BM_Bowen_UnpackIndexLoop(benchmark::State& state) {
+  const BitVector<> bits = random_bits(state.range(0), 500);
+  std::vector<uint8_t> out(bits.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < bits.size(); ++i)
+      out[i] = bits[i];
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * bits.size());
+}
+
+static void BM_Bowen_UnpackToBytes(benchmark::State& state) {
+  const BitVector<> bits = random_bits(state.range(0), 500);
+  std::vector<uint8_t> out(bits.size());
+  for (auto _ : state) {
+    bits.unpack_to_bytes(out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * bits.size());
+}
+
+static void BM_Bowen_UnpackToBytesOffset(benchmark::State& state) {
+  const BitVector<> bits = random_bits(state.range(0), 500);
+  std::vector<uint8_t> out(bits.size());
+  for (auto _ : state) {
+    bits.unpack_to_bytes(out.data(), 3, bits.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * (bits.size() - 3));
+}
+
+static void BM_Bowen_UnpackToInt32Mask(benchmark::State& state) {
+  const BitVector<> bits = random_bits(state.range(0), 500);
+  std::vector<int32_t> out(bits.size());
+  for (auto _ : state) {
+    bits.unpack_to_int32_mask(out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * bits.size());
+}
+
+BENCHMARK(BM_Bowen_Set)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_Set)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_PushBack)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_PushBack)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_AppendBools)->Args({1<<20, 0})->Args({1<<20, 1})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_Access)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_Access)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SetBit)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_SetBit)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SetBitTrueUnsafe)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_SetBitTrueUnsafe)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SetBitTrue6)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_SetBitTrue6)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_QSetBitTrue6V2)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_QSetBitTrue6)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_IncrementUntilZero)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_IncrementUntilZero)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+
+BENCHMARK(BM_Bowen_And)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_And)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_OrOutOfPlace)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_OrOutOfPlace)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_Flip)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_Flip)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+
+// Sizes chosen to sit in L1 (32 KiB), L2 (1 MiB), LLC (16 MiB) and DRAM (128 MiB).
+BENCHMARK(BM_Bowen_Count)->Arg(1<<18)->Arg(1<<23)->Arg(1<<27)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_Count)->Arg(1<<18)->Arg(1<<23)->Arg(1<<27)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_AndCount)->Arg(1<<18)->Arg(1<<23)->Arg(1<<27)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_AndThenCount)->Arg(1<<18)->Arg(1<<23)->Arg(1<<27)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_Rank1)->Arg(1<<20)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_Select1)->Arg(1<<20)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_Select0)->Arg(1<<20)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_RankLinearCount)->Arg(1<<20)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_FindNextOneSparse)->Arg(1<<20)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_FindNextOneSparse)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_FindPrevZeroDense)->Arg(1<<20)->Arg(1<<30)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ExtractOnes)->ArgsProduct({{1<<20}, {1, 10, 100, 500, 900}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ExtractOnesIterator)->ArgsProduct({{1<<20}, {1, 10, 100, 500, 900}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SetRange)->Arg(40)->Arg(1<<20)->Arg(1<<26)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SetRangePerBit)->Arg(40)->Arg(1<<20)->Arg(1<<26)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_FlipRange)->Arg(40)->Arg(1<<20)->Arg(1<<26)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_NoneRange)->Arg(40)->Arg(1<<20)->Arg(1<<26)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ShiftLeft)->ArgsProduct({{1<<20}, {1, 64, 1000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ShiftRightInto)->ArgsProduct({{1<<20}, {1, 64, 1000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_RotateLeftInto)->ArgsProduct({{1<<20}, {1, 1000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ShiftLeftPerBit)->ArgsProduct({{1<<20}, {1000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ExprEager)->Arg(1<<20)->Arg(100000000)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ExprFused)->Arg(1<<20)->Arg(100000000)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ExprFusedCount)->Arg(1<<20)->Arg(100000000)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SetStride)->ArgsProduct({{1<<26}, {1, 3, 6, 64, 100, 1000, 100000, 1000000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SetStridePerBit)->ArgsProduct({{1<<26}, {1, 3, 6, 64, 100, 1000, 100000, 1000000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_SetStride)->ArgsProduct({{1<<26}, {1, 3, 6, 64, 100, 1000, 100000, 1000000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_PrimeCount)->ArgsProduct({{1000000000, 10000000000}, {1, 0}})->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_PrimeIterate)->Arg(1000000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ParallelAssign)->ArgsProduct({{1000000000}, {1, 2, 4, 8, 16}})->UseRealTime()->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ParallelCopy)->ArgsProduct({{1000000000}, {1, 2, 4, 8, 16}})->UseRealTime()->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ParallelAnd)->ArgsProduct({{1000000000}, {1, 2, 4, 8, 16}})->UseRealTime()->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ParallelCount)->ArgsProduct({{1000000000}, {1, 2, 4, 8, 16}})->UseRealTime()->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ParallelFindFirst)->ArgsProduct({{1000000000}, {1, 2, 4, 8, 16}})->UseRealTime()->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_AtomicSet)->Arg(4096)->Arg(1<<24)->ThreadRange(1, 16)->UseRealTime()->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_AtomicTestAndSet)->Arg(4096)->Arg(1<<24)->ThreadRange(1, 16)->UseRealTime()->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_AtomicFetchOrWord)->Arg(4096)->Arg(1<<24)->ThreadRange(1, 16)->UseRealTime()->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_AtomicTest)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_PlainTest)->Arg(1<<20)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_RoaringAnd)->ArgsProduct({{1<<25}, {100, 10000, 100000, 500000, 990000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_RoaringOr)->ArgsProduct({{1<<25}, {100, 10000, 100000, 500000, 990000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_FlatAnd)->ArgsProduct({{1<<25}, {100, 10000, 100000, 500000, 990000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_FlatOr)->ArgsProduct({{1<<25}, {100, 10000, 100000, 500000, 990000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_EwahAnd)->ArgsProduct({{1<<27}, {1000, 10000, 100000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_EwahOr)->ArgsProduct({{1<<27}, {1000, 10000, 100000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_EwahCount)->ArgsProduct({{1<<27}, {1000, 10000, 100000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_FlatRunAnd)->ArgsProduct({{1<<27}, {1000, 10000, 100000}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_MappedOpen)->Arg(1000000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_MappedOpenCount)->Arg(1000000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ReadLoad)->Arg(1000000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ReadLoadCount)->Arg(1000000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_Crc32c)->Arg(1<<12)->Arg(1<<24)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_Save)->Arg(1<<27)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_LoadView)->ArgsProduct({{1000000000}, {0, 1}})->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SpanCount)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SpanCopy)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SpanEqual)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_IterCount)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_IterCount)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_IterFind)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_IterFind)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_IterFill)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_IterFill)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_IterCopy)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_IterCopy)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_IterEqual)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Std_IterEqual)->ArgsProduct({{1<<20}, {0, 3}})->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ShuffleVectors)->Arg(256)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SmallConstruct)->Arg(10000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_HeapConstruct)->Arg(10000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_SmallAccess)->Arg(10000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_HeapAccess)->Arg(10000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayAndCount, 64)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayAndCount, 256)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayAndCount, 1024)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayAndCount, 4096)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetAndCount, 64)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetAndCount, 256)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetAndCount, 1024)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetAndCount, 4096)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayOrAssign, 64)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayOrAssign, 256)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayOrAssign, 1024)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayOrAssign, 4096)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetOrAssign, 64)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetOrAssign, 256)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetOrAssign, 1024)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetOrAssign, 4096)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayFindFirst, 64)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayFindFirst, 256)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayFindFirst, 1024)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Bowen_ArrayFindFirst, 4096)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+#if defined(__GLIBCXX__)
+BENCHMARK_TEMPLATE(BM_Std_BitsetFindFirst, 64)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetFindFirst, 256)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetFindFirst, 1024)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK_TEMPLATE(BM_Std_BitsetFindFirst, 4096)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+#endif
+BENCHMARK(BM_Std_QueryTemporaries)->Arg(256)->Arg(4096)->Arg(1<<16)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_MMQueryTemporaries)->Arg(256)->Arg(4096)->Arg(1<<16)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_ArenaQueryTemporaries)->Arg(256)->Arg(4096)->Arg(1<<16)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_RandomAccess)->Arg(1000000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_HugePageRandomAccess)->Arg(1000000000)->Unit(benchmark::kMillisecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_UnpackIndexLoop)->Arg(1<<20)->Arg(100000000)->Unit(benchmark::kMicrosecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_UnpackToBytes)->Arg(1<<20)->Arg(100000000)->Unit(benchmark::kMicrosecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_UnpackToBytesOffset)->Arg(1<<20)->Arg(100000000)->Unit(benchmark::kMicrosecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
+BENCHMARK(BM_Bowen_UnpackToInt32Mask)->Arg(1<<20)->Arg(100000000)->Unit(benchmark::kMicrosecond)->MinTime(BITVECTOR_BENCHMARK_MIN_TIME);
 
 BENCHMARK_MAIN();
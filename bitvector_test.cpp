@@ -1,5 +1,20 @@
+#include "arena_allocator.hpp"
+#include "atomic_bitvector.hpp"
+#include "bit_array.hpp"
 #include "bitvector.hpp"
+#include "ewah.hpp"
+#include "hugepage_allocator.hpp"
+#include "mapped_bitvector.hpp"
+#include "parallel.hpp"
+#include "rank_select.hpp"
+#include "roaring.hpp"
+#include "serialize.hpp"
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <bitset>
+#include <random>
+#include <thread>
 
 TEST(BitvectorTest, PushBackBasic) {
     bowen::BitVector<> bv;
@@ -95,3 +110,1388 @@ TEST(BitvectorTest, IteratorTraversal) {
     EXPECT_FALSE(values[1]);
     EXPECT_TRUE(values[2]);
 }
+
+TEST(BitvectorTest, RandomAccessIterators) {
+    const size_t N = 200; // end() lands inside the last word
+    bowen::BitVector<> bv(N);
+    for (size_t i = 0; i < N; i += 3)
+        bv.set_bit(i, true);
+
+    auto first = bv.begin();
+    auto last = bv.end();
+    EXPECT_EQ(last - first, static_cast<std::ptrdiff_t>(N));
+    EXPECT_EQ(std::distance(first, last), static_cast<std::ptrdiff_t>(N));
+    EXPECT_TRUE(first < last);
+    EXPECT_TRUE(first + 130 == last - 70);
+    EXPECT_EQ((last - 1) - first, static_cast<std::ptrdiff_t>(N - 1));
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(static_cast<bool>(first[i]), bv[i]);
+        EXPECT_EQ(*(last - static_cast<std::ptrdiff_t>(N - i)), bv[i]);
+    }
+    auto it = first;
+    it += 129;
+    it -= 65;
+    EXPECT_EQ(it - first, 64);
+    *it = true;
+    EXPECT_TRUE(bv[64]);
+
+    const bowen::BitVector<>& cbv = bv;
+    bowen::BitVector<>::const_iterator cit = bv.begin();
+    EXPECT_TRUE(cit == cbv.begin());
+    EXPECT_EQ(cbv.cend() - cbv.cbegin(), static_cast<std::ptrdiff_t>(N));
+    EXPECT_EQ(cit[64], true);
+    static_assert(std::is_same<std::iterator_traits<bowen::BitVector<>::iterator>::iterator_category,
+                               std::random_access_iterator_tag>::value, "random access");
+
+    // The std algorithms accept the iterators as they are.
+    std::vector<bool> copied(bv.begin(), bv.end());
+    EXPECT_EQ(copied.size(), N);
+    EXPECT_EQ(std::count(copied.begin(), copied.end(), true), std::count(cbv.begin(), cbv.end(), true));
+}
+
+TEST(BitvectorTest, IteratorAlgorithmsMatchVectorBool) {
+    const size_t N = 1500;
+    std::mt19937_64 rng(18);
+    bowen::BitVector<> bv(N);
+    std::vector<bool> ref(N);
+    for (size_t i = 0; i < N; ++i) {
+        const bool b = (rng() & 7) == 0;
+        bv.set_bit(i, b);
+        ref[i] = b;
+    }
+    const bowen::BitVector<>& cbv = bv;
+    const size_t edges[] = {0, 1, 63, 64, 65, 300, 777, 1499, 1500};
+    for (size_t l : edges) {
+        for (size_t r : edges) {
+            if (l > r)
+                continue;
+            for (bool value : {false, true}) {
+                using std::count;
+                using std::find;
+                EXPECT_EQ(count(cbv.begin() + l, cbv.begin() + r, value),
+                          std::count(ref.begin() + l, ref.begin() + r, value));
+                EXPECT_EQ(find(bv.begin() + l, bv.begin() + r, value) - bv.begin(),
+                          std::find(ref.begin() + l, ref.begin() + r, value) - ref.begin());
+            }
+        }
+    }
+
+    // copy and equal at every source/destination offset pair in a word.
+    for (size_t soff : {0, 5, 63}) {
+        for (size_t doff : {0, 1, 40}) {
+            for (size_t n : {0, 3, 64, 700}) {
+                bowen::BitVector<> out(N, true);
+                std::vector<bool> rout(N, true);
+                using std::copy;
+                auto end = copy(cbv.begin() + soff, cbv.begin() + soff + n, out.begin() + doff);
+                std::copy(ref.begin() + soff, ref.begin() + soff + n, rout.begin() + doff);
+                EXPECT_EQ(end - out.begin(), static_cast<std::ptrdiff_t>(doff + n));
+                for (size_t i = 0; i < N; ++i)
+                    ASSERT_EQ(out[i], rout[i]) << soff << " " << doff << " " << n << " " << i;
+                using std::equal;
+                EXPECT_TRUE(equal(out.begin() + doff, out.begin() + doff + n, cbv.begin() + soff));
+                if (n) {
+                    out[doff + n / 2].flip();
+                    EXPECT_FALSE(equal(out.begin() + doff, out.begin() + doff + n, cbv.begin() + soff));
+                }
+            }
+        }
+    }
+
+    // Shifting left within one vector, as erase does.
+    bowen::BitVector<> shifted = bv;
+    std::vector<bool> rshifted = ref;
+    bowen::copy(shifted.begin() + 70, shifted.end(), shifted.begin() + 3);
+    std::copy(rshifted.begin() + 70, rshifted.end(), rshifted.begin() + 3);
+    for (size_t i = 0; i < N; ++i)
+        ASSERT_EQ(shifted[i], rshifted[i]) << i;
+
+    using std::fill;
+    fill(bv.begin() + 10, bv.begin() + 1000, true);
+    std::fill(ref.begin() + 10, ref.begin() + 1000, true);
+    fill(bv.begin() + 200, bv.begin() + 201, false);
+    std::fill(ref.begin() + 200, ref.begin() + 201, false);
+    for (size_t i = 0; i < N; ++i)
+        ASSERT_EQ(bv[i], ref[i]) << i;
+}
+
+TEST(BitvectorTest, MoveSwapAndLifecycle) {
+    bowen::BitVector<> a(1000);
+    a.set_bit(7, true);
+    a.set_bit(999, true);
+    const bowen::BitType* storage = a.data();
+
+    bowen::BitVector<> b(std::move(a));
+    EXPECT_EQ(b.data(), storage);
+    EXPECT_EQ(b.size(), 1000u);
+    EXPECT_TRUE(b[7] && b[999]);
+    EXPECT_EQ(a.size(), 0u);
+    a.push_back(true); // a moved-from vector is empty and usable
+    EXPECT_TRUE(a[0]);
+
+    bowen::BitVector<> c(10);
+    c = std::move(b);
+    EXPECT_EQ(c.data(), storage);
+    EXPECT_EQ(c.count(), 2u);
+    static_assert(std::is_nothrow_move_constructible<bowen::BitVector<>>::value, "noexcept move");
+    static_assert(std::is_nothrow_move_assignable<bowen::BitVector<>>::value, "noexcept move");
+
+    // Copy assignment keeps storage that is large enough.
+    bowen::BitVector<> small(300, true);
+    c = small;
+    EXPECT_EQ(c.data(), storage);
+    EXPECT_EQ(c.size(), 300u);
+    EXPECT_EQ(c.count(), 300u);
+    bowen::BitVector<> large(5000, true);
+    c = large;
+    EXPECT_EQ(c.count(), 5000u);
+
+    swap(c, small);
+    EXPECT_EQ(c.size(), 300u);
+    EXPECT_EQ(small.size(), 5000u);
+    c.swap(small);
+    EXPECT_EQ(c.size(), 5000u);
+
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    const bowen::BitType* kept = c.data();
+    c.push_back(true);
+    EXPECT_EQ(c.data(), kept);
+    c.shrink_to_fit();
+    EXPECT_EQ(c.size(), 1u);
+    EXPECT_TRUE(c[0]);
+    c.clear();
+    c.shrink_to_fit();
+    EXPECT_EQ(c.data(), nullptr);
+
+    // Reallocating a vector of vectors moves the storage instead of copying it.
+    std::vector<bowen::BitVector<>> many;
+    many.emplace_back(4096, true);
+    const bowen::BitType* first = many[0].data();
+    for (int i = 0; i < 20; ++i)
+        many.emplace_back(64);
+    EXPECT_EQ(many[0].data(), first);
+    EXPECT_EQ(many[0].count(), 4096u);
+}
+
+TEST(BitvectorTest, SmallBitVectorSpillsPastInlineBits) {
+    typedef bowen::SmallBitVector<256> Small;
+    static_assert(sizeof(bowen::BitVector<>) == 4 * sizeof(void*), "no inline words by default");
+
+    Small a(200);
+    const auto inside = [](const Small& v) {
+        const char* p = reinterpret_cast<const char*>(v.data());
+        const char* self = reinterpret_cast<const char*>(&v);
+        return p >= self && p < self + sizeof(Small);
+    };
+    EXPECT_TRUE(inside(a));
+    a.set_bit(3, true);
+    a.set_bit(199, true);
+
+    // Growing past 256 bits moves the bits to the allocator.
+    Small grown;
+    std::vector<bool> ref;
+    for (size_t i = 0; i < 1000; ++i) {
+        const bool b = (i % 7) == 2;
+        grown.push_back(b);
+        ref.push_back(b);
+        EXPECT_EQ(inside(grown), i < 256) << i;
+    }
+    for (size_t i = 0; i < ref.size(); ++i)
+        ASSERT_EQ(grown[i], ref[i]) << i;
+
+    // Copies, moves and swaps between inline and heap vectors.
+    Small b = a;
+    EXPECT_TRUE(inside(b));
+    EXPECT_TRUE(b == a);
+    Small c(std::move(b));
+    EXPECT_TRUE(inside(c));
+    EXPECT_TRUE(c[3] && c[199]);
+    EXPECT_TRUE(b.empty());
+    Small heap = grown;
+    swap(c, heap);
+    EXPECT_EQ(c.size(), 1000u);
+    EXPECT_EQ(heap.size(), 200u);
+    EXPECT_TRUE(inside(heap));
+    EXPECT_TRUE(heap[3] && heap[199]);
+    EXPECT_EQ(c.count(), grown.count());
+    heap = std::move(c);
+    EXPECT_EQ(heap.count(), grown.count());
+
+    // Bitwise expressions and shrinking back inline.
+    Small mask(200, true);
+    Small both = a & ~mask;
+    EXPECT_TRUE(both.none());
+    both = a | mask;
+    EXPECT_EQ(both.count(), 200u);
+    heap.assign(100, true);
+    heap.shrink_to_fit();
+    EXPECT_TRUE(inside(heap));
+    EXPECT_EQ(heap.count(), 100u);
+}
+
+TEST(BitvectorTest, BulkAppendMatchesPushBack) {
+    std::mt19937 rng(24);
+    std::vector<uint8_t> flags(1000);
+    const uint8_t values[] = {0, 0, 1, 2, 0x80, 0xff};
+    for (uint8_t& f : flags)
+        f = values[rng() % 6];
+    for (size_t start : {0, 1, 63, 64, 100}) {
+        for (size_t n : {0, 5, 64, 130, 1000}) {
+            bowen::BitVector<> expected, bools, words;
+            for (size_t i = 0; i < start; ++i) {
+                expected.push_back(i % 3 == 0);
+                bools.push_back(i % 3 == 0);
+                words.push_back(i % 3 == 0);
+            }
+            std::vector<bowen::BitType> packed((n + 63) / 64 + 1, ~0ul);
+            for (size_t i = 0; i < n; ++i) {
+                expected.push_back(flags[i] != 0);
+                if (!flags[i])
+                    packed[i / 64] &= ~(1ul << (i % 64));
+            }
+            bools.append_bools(flags.data(), n);
+            words.append_words(packed.data(), n);
+            ASSERT_EQ(bools.size(), start + n);
+            EXPECT_TRUE(bools == expected) << start << " " << n;
+            EXPECT_TRUE(words == expected) << start << " " << n;
+            words.push_back(true);
+            EXPECT_TRUE(words[start + n]);
+        }
+    }
+
+    bowen::BitVector<> assigned(2000, true);
+    assigned.assign_from_bytes(flags.data(), 130);
+    ASSERT_EQ(assigned.size(), 130u);
+    for (size_t i = 0; i < 130; ++i)
+        EXPECT_EQ(assigned[i], flags[i] != 0);
+    const bool bools[3] = {true, false, true};
+    assigned.append_bools(bools, 3);
+    EXPECT_EQ(assigned.count(130, 133), 2u);
+}
+
+TEST(BitvectorTest, UnpackMatchesOperatorIndex) {
+    std::mt19937_64 rng(25);
+    bowen::BitVector<> bits(1000);
+    for (size_t i = 0; i < bits.size(); ++i)
+        bits.set_bit(i, rng() & 1);
+    std::vector<uint8_t> bytes(1001, 7);
+    std::vector<int32_t> lanes(1001, 7);
+    bool bools[1000];
+    bits.unpack_to_bytes(bytes.data());
+    bits.unpack_to_int32_mask(lanes.data());
+    bits.unpack_to_bool(bools);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        EXPECT_EQ(bytes[i], bits[i] ? 1 : 0);
+        EXPECT_EQ(lanes[i], bits[i] ? -1 : 0);
+        EXPECT_EQ(bools[i], bits[i]);
+    }
+    for (size_t l : {0, 1, 37, 64, 130}) {
+        for (size_t r : {130, 131, 200, 999, 1000}) {
+            std::fill(bytes.begin(), bytes.end(), 7);
+            std::fill(lanes.begin(), lanes.end(), 7);
+            bits.unpack_to_bytes(bytes.data(), l, r);
+            bits.unpack_to_int32_mask(lanes.data(), l, r);
+            for (size_t i = l; i < r; ++i) {
+                ASSERT_EQ(bytes[i - l], bits[i] ? 1 : 0) << l << " " << r << " " << i;
+                ASSERT_EQ(lanes[i - l], bits[i] ? -1 : 0) << l << " " << r << " " << i;
+            }
+            // Nothing is written past the range.
+            EXPECT_EQ(bytes[r - l], 7);
+            EXPECT_EQ(lanes[r - l], 7);
+        }
+    }
+#ifndef BITVECTOR_NO_BOUND_CHECK
+    EXPECT_THROW(bits.unpack_to_bytes(bytes.data(), 10, 1001), std::out_of_range);
+#endif
+}
+
+TEST(BitvectorTest, BitwiseOperators) {
+    const size_t N = 1000; // not a multiple of the SIMD width
+    bowen::BitVector<> a(N), b(N);
+    std::vector<bool> ra(N), rb(N);
+    for (size_t i = 0; i < N; ++i) {
+        ra[i] = (i % 3) == 0;
+        rb[i] = (i % 5) < 2;
+        a.set_bit(i, ra[i]);
+        b.set_bit(i, rb[i]);
+    }
+
+    bowen::BitVector<> and_v = a & b;
+    bowen::BitVector<> or_v = a | b;
+    bowen::BitVector<> xor_v = a ^ b;
+    bowen::BitVector<> andnot_v = andnot(a, b);
+    bowen::BitVector<> not_v = ~a;
+    ASSERT_EQ(and_v.size(), N);
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(and_v[i], ra[i] && rb[i]);
+        EXPECT_EQ(or_v[i], ra[i] || rb[i]);
+        EXPECT_EQ(xor_v[i], ra[i] != rb[i]);
+        EXPECT_EQ(andnot_v[i], ra[i] && !rb[i]);
+        EXPECT_EQ(not_v[i], !ra[i]);
+    }
+
+    bowen::BitVector<> c(a);
+    c &= b;
+    c |= not_v;
+    c ^= b;
+    c.andnot(xor_v);
+    for (size_t i = 0; i < N; ++i) {
+        bool expected = ((ra[i] && rb[i]) || !ra[i]) != rb[i];
+        expected = expected && !(ra[i] != rb[i]);
+        EXPECT_EQ(c[i], expected);
+    }
+}
+
+TEST(BitvectorTest, FlipInPlaceWithAlignedAllocator) {
+    using AlignedVector = bowen::BitVector<bowen::MMAllocator<bowen::BitType>>;
+    AlignedVector bv(777);
+    for (size_t i = 0; i < bv.size(); i += 7)
+        bv.set_bit(i, true);
+    bv.flip();
+    for (size_t i = 0; i < bv.size(); ++i)
+        EXPECT_EQ(bv[i], i % 7 != 0);
+}
+
+TEST(BitvectorTest, CountMatchesPerBitScan) {
+    const size_t N = 3 * 4096 + 77; // several Harley-Seal blocks plus a tail
+    std::mt19937_64 rng(42);
+    bowen::BitVector<> bv(N, true); // storage past size() starts out set
+    std::vector<bool> ref(N);
+    for (size_t i = 0; i < N; ++i) {
+        ref[i] = (rng() % 3) == 0;
+        bv.set_bit(i, ref[i]);
+    }
+    size_t expected = 0;
+    for (size_t i = 0; i < N; ++i)
+        expected += ref[i];
+    EXPECT_EQ(bv.count(), expected);
+
+    for (int trial = 0; trial < 200; ++trial) {
+        size_t l = rng() % (N + 1);
+        size_t r = rng() % (N + 1);
+        if (l > r)
+            std::swap(l, r);
+        size_t in_range = 0;
+        for (size_t i = l; i < r; ++i)
+            in_range += ref[i];
+        EXPECT_EQ(bv.count(l, r), in_range) << "l=" << l << " r=" << r;
+    }
+    EXPECT_EQ(bv.count(0, N), expected);
+    EXPECT_EQ(bv.count(64, 128), static_cast<size_t>(std::count(ref.begin() + 64, ref.begin() + 128, true)));
+}
+
+TEST(BitvectorTest, FusedCounts) {
+    const size_t N = 10000;
+    std::mt19937_64 rng(7);
+    bowen::BitVector<> a(N), b(N);
+    size_t and_ref = 0, or_ref = 0, xor_ref = 0, andnot_ref = 0;
+    for (size_t i = 0; i < N; ++i) {
+        bool x = rng() & 1, y = (rng() % 5) == 0;
+        a.set_bit(i, x);
+        b.set_bit(i, y);
+        and_ref += x && y;
+        or_ref += x || y;
+        xor_ref += x != y;
+        andnot_ref += x && !y;
+    }
+    EXPECT_EQ(and_count(a, b), and_ref);
+    EXPECT_EQ(or_count(a, b), or_ref);
+    EXPECT_EQ(xor_count(a, b), xor_ref);
+    EXPECT_EQ(andnot_count(a, b), andnot_ref);
+    EXPECT_EQ(and_count(a, b), (a & b).count());
+}
+
+TEST(BitvectorTest, FindFamilyMatchesLinearScan) {
+    const size_t npos = bowen::BitVector<>::npos;
+    std::mt19937_64 rng(99);
+    for (size_t n : {1u, 64u, 200u, 1000u, 4099u}) {
+        for (int density : {0, 1, 50, 99, 100}) {
+            bowen::BitVector<> bv(n, density == 100); // tail storage matches the fill
+            std::vector<bool> ref(n);
+            for (size_t i = 0; i < n; ++i) {
+                ref[i] = static_cast<int>(rng() % 100) < density;
+                bv.set_bit(i, ref[i]);
+            }
+            for (size_t pos = 0; pos <= n; ++pos) {
+                size_t next_one = npos, next_zero = npos, prev_one = npos, prev_zero = npos;
+                for (size_t i = pos; i < n; ++i) {
+                    if (ref[i] && next_one == npos) next_one = i;
+                    if (!ref[i] && next_zero == npos) next_zero = i;
+                }
+                for (size_t i = pos; i-- > 0;) {
+                    if (ref[i] && prev_one == npos) prev_one = i;
+                    if (!ref[i] && prev_zero == npos) prev_zero = i;
+                }
+                ASSERT_EQ(bv.find_next_one(pos), next_one) << "n=" << n << " pos=" << pos;
+                ASSERT_EQ(bv.find_next_zero(pos), next_zero) << "n=" << n << " pos=" << pos;
+                ASSERT_EQ(bv.find_prev_one(pos), prev_one) << "n=" << n << " pos=" << pos;
+                ASSERT_EQ(bv.find_prev_zero(pos), prev_zero) << "n=" << n << " pos=" << pos;
+            }
+        }
+    }
+}
+
+TEST(BitvectorTest, FindFirstAndLastSparse) {
+    const size_t N = 100000;
+    bowen::BitVector<> bv(N);
+    EXPECT_EQ(bv.find_first_one(), bowen::BitVector<>::npos);
+    EXPECT_EQ(bv.find_last_one(), bowen::BitVector<>::npos);
+    EXPECT_EQ(bv.find_first_zero(), 0u);
+    EXPECT_EQ(bv.find_last_zero(), N - 1);
+
+    bv.set_bit(777, true);
+    bv.set_bit(65000, true);
+    EXPECT_EQ(bv.find_first_one(), 777u);
+    EXPECT_EQ(bv.find_next_one(778), 65000u);
+    EXPECT_EQ(bv.find_next_one(65001), bowen::BitVector<>::npos);
+    EXPECT_EQ(bv.find_last_one(), 65000u);
+    EXPECT_EQ(bv.find_prev_one(65000), 777u);
+
+    bowen::BitVector<> dense(N, true);
+    dense.set_bit(N - 3, false);
+    size_t pos = 1;
+    dense.incrementUntilZero(pos);
+    EXPECT_EQ(pos, N - 3);
+    pos = N - 2;
+    dense.incrementUntilZero(pos);
+    EXPECT_EQ(pos, N);
+}
+
+TEST(BitvectorTest, ExtractOnes) {
+    std::mt19937_64 rng(5);
+    for (int density : {1, 30, 95}) {
+        const size_t N = 5000;
+        bowen::BitVector<> bv(N, true);
+        std::vector<uint64_t> ref;
+        for (size_t i = 0; i < N; ++i) {
+            bool bit = static_cast<int>(rng() % 100) < density;
+            bv.set_bit(i, bit);
+            if (bit)
+                ref.push_back(i);
+        }
+
+        std::vector<uint64_t> out64(ref.size());
+        ASSERT_EQ(bv.extract_ones(out64.data()), ref.size());
+        EXPECT_EQ(out64, ref);
+
+        std::vector<uint32_t> out32(ref.size());
+        ASSERT_EQ(bv.extract_ones(out32.data(), 1000), ref.size());
+        for (size_t k = 0; k < ref.size(); ++k)
+            ASSERT_EQ(out32[k], ref[k] + 1000);
+
+        // Small bounded buffer: concatenated chunks equal the full extraction.
+        std::vector<uint32_t> streamed;
+        uint32_t chunk[7];
+        size_t pos = 0;
+        for (size_t got; (got = bv.extract_ones(chunk, 7, pos)) != 0;)
+            streamed.insert(streamed.end(), chunk, chunk + got);
+        EXPECT_EQ(pos, N);
+        ASSERT_EQ(streamed.size(), ref.size());
+        for (size_t k = 0; k < ref.size(); ++k)
+            ASSERT_EQ(streamed[k], ref[k]);
+    }
+}
+
+TEST(BitvectorTest, RangeMutatorsAndPredicates) {
+    std::mt19937_64 rng(11);
+    const size_t N = 1500;
+    bowen::BitVector<> bv(N);
+    std::vector<bool> ref(N);
+    for (int trial = 0; trial < 300; ++trial) {
+        size_t l = rng() % (N + 1);
+        size_t r = rng() % (N + 1);
+        if (l > r)
+            std::swap(l, r);
+        switch (trial % 3) {
+            case 0:
+                bv.set_range(l, r);
+                for (size_t i = l; i < r; ++i) ref[i] = true;
+                break;
+            case 1:
+                bv.clear_range(l, r);
+                for (size_t i = l; i < r; ++i) ref[i] = false;
+                break;
+            default:
+                bv.flip_range(l, r);
+                for (size_t i = l; i < r; ++i) ref[i] = !ref[i];
+                break;
+        }
+        for (size_t i = 0; i < N; ++i)
+            ASSERT_EQ(bv[i], ref[i]) << "trial=" << trial << " i=" << i;
+
+        size_t ql = rng() % (N + 1);
+        size_t qr = rng() % (N + 1);
+        if (ql > qr)
+            std::swap(ql, qr);
+        bool any_ref = false, all_ref = true;
+        for (size_t i = ql; i < qr; ++i) {
+            any_ref = any_ref || ref[i];
+            all_ref = all_ref && ref[i];
+        }
+        EXPECT_EQ(bv.any(ql, qr), any_ref);
+        EXPECT_EQ(bv.none(ql, qr), !any_ref);
+        EXPECT_EQ(bv.all(ql, qr), all_ref);
+    }
+}
+
+TEST(BitvectorTest, WholeVectorPredicatesIgnoreTailStorage) {
+    bowen::BitVector<> ones(100, true);
+    EXPECT_TRUE(ones.all());
+    ones.clear_range(0, 100);
+    EXPECT_TRUE(ones.none());
+    EXPECT_FALSE(ones.any());
+    ones.set_range(99, 100);
+    EXPECT_TRUE(ones.any());
+    EXPECT_FALSE(ones.all());
+}
+
+TEST(BitvectorTest, ShiftAndRotate) {
+    std::mt19937_64 rng(17);
+    for (size_t n : {1u, 320u, 1000u, 2111u}) {
+        bowen::BitVector<> src(n, true); // tail storage set, must not leak in
+        std::vector<bool> ref(n);
+        for (size_t i = 0; i < n; ++i) {
+            ref[i] = rng() & 1;
+            src.set_bit(i, ref[i]);
+        }
+        for (size_t k : {size_t(0), size_t(1), size_t(7), size_t(63), size_t(64), size_t(65),
+                         size_t(130), size_t(517), n - 1, n, n + 5}) {
+            bowen::BitVector<> left(src), right(src), into(n), rot(n);
+            left <<= k;
+            right >>= k;
+            for (size_t i = 0; i < n; ++i) {
+                ASSERT_EQ(left[i], i >= k && ref[i - k]) << "n=" << n << " k=" << k << " i=" << i;
+                ASSERT_EQ(right[i], i + k < n && ref[i + k]) << "n=" << n << " k=" << k << " i=" << i;
+            }
+            src.shift_right_into(into, k);
+            for (size_t i = 0; i < n; ++i)
+                ASSERT_EQ(into[i], right[i]);
+
+            src.rotate_left_into(rot, k);
+            for (size_t i = 0; i < n; ++i)
+                ASSERT_EQ(rot[i], ref[(i + n - k % n) % n]) << "n=" << n << " k=" << k << " i=" << i;
+            bowen::BitVector<> back(rot);
+            back.rotate_right(k);
+            for (size_t i = 0; i < n; ++i)
+                ASSERT_EQ(back[i], ref[i]);
+        }
+    }
+}
+
+TEST(BitvectorTest, LazyExpressions) {
+    const size_t N = 1234;
+    std::mt19937_64 rng(23);
+    bowen::BitVector<> a(N), b(N), c(N), d(N);
+    std::vector<bool> ra(N), rb(N), rc(N), rd(N);
+    for (size_t i = 0; i < N; ++i) {
+        ra[i] = rng() & 1; rb[i] = rng() & 1; rc[i] = rng() & 1; rd[i] = rng() & 1;
+        a.set_bit(i, ra[i]); b.set_bit(i, rb[i]); c.set_bit(i, rc[i]); d.set_bit(i, rd[i]);
+    }
+
+    bowen::BitVector<> r = (a & b) | (c & ~d);
+    size_t expected_count = 0;
+    for (size_t i = 0; i < N; ++i) {
+        bool expected = (ra[i] && rb[i]) || (rc[i] && !rd[i]);
+        ASSERT_EQ(r[i], expected);
+        expected_count += expected;
+    }
+    EXPECT_EQ(((a & b) | (c & ~d)).count(), expected_count);
+    EXPECT_EQ(r.count(), expected_count);
+    EXPECT_TRUE((a | ~a).all());
+    EXPECT_TRUE((a & ~a).none());
+    EXPECT_FALSE((a ^ a).any());
+
+    // Assigning an expression that reads the destination.
+    bowen::BitVector<> x(a);
+    x = andnot(x, b) ^ c;
+    x |= b & d;
+    for (size_t i = 0; i < N; ++i)
+        ASSERT_EQ(x[i], (((ra[i] && !rb[i]) != rc[i]) || (rb[i] && rd[i])));
+
+    // Assignment grows an empty destination.
+    bowen::BitVector<> empty;
+    empty = a ^ b;
+    ASSERT_EQ(empty.size(), N);
+    EXPECT_EQ(empty.count(), xor_count(a, b));
+}
+
+TEST(BitvectorTest, SetStrideMatchesPerBit) {
+    std::mt19937_64 rng(31);
+    const size_t N = 20000;
+    for (size_t stride : {1u, 2u, 3u, 6u, 7u, 64u, 96u, 100u, 255u, 256u, 257u, 1000u, 19999u}) {
+        for (bool value : {true, false}) {
+            bowen::BitVector<> bv(N);
+            std::vector<bool> ref(N);
+            for (size_t i = 0; i < N; ++i) {
+                ref[i] = rng() & 1;
+                bv.set_bit(i, ref[i]);
+            }
+            const size_t start = rng() % 200;
+            const size_t max_count = (N - 1 - start) / stride + 1;
+            const size_t count = max_count - rng() % std::min<size_t>(max_count, 5);
+            bv.set_stride(start, stride, count, value);
+            for (size_t j = 0; j < count; ++j)
+                ref[start + j * stride] = value;
+            for (size_t i = 0; i < N; ++i)
+                ASSERT_EQ(bv[i], ref[i]) << "stride=" << stride << " value=" << value << " i=" << i;
+        }
+    }
+}
+
+TEST(BitvectorTest, LegacyStrideSetters) {
+    bowen::BitVector<> bv(100);
+    bv.set_bit_true_6(3, 10);
+    EXPECT_EQ(bv.count(), 6u);
+    for (size_t i = 3; i <= 53; i += 10)
+        EXPECT_TRUE(bv[i]);
+
+    bowen::BitVector<> q(1000);
+    q.qset_bit_true_6_v2(1, 3, 300);
+    EXPECT_EQ(q.count(), 300u);
+    EXPECT_TRUE(q[898]);
+    EXPECT_FALSE(q[901]);
+}
+
+TEST(BitvectorTest, ParallelOpsMatchSerial) {
+    bowen::ThreadPool pool(4);
+    // Tiny chunks so every operation is split into many stolen tasks.
+    bowen::ParallelPolicy par(pool, 8);
+    std::mt19937_64 rng(37);
+    for (size_t n : {0u, 1u, 64u, 511u, 4097u, 100003u}) {
+        bowen::BitVector<> a(n), b(n);
+        for (size_t i = 0; i < n; ++i) {
+            a.set_bit(i, rng() & 1);
+            b.set_bit(i, rng() % 3 == 0);
+        }
+        EXPECT_EQ(a.count(par), a.count());
+
+        bowen::BitVector<> c;
+        c.assign(par, a);
+        bowen::BitVector<> expected = a & b;
+        c.and_assign(par, b);
+        EXPECT_EQ(c.count(), expected.count());
+        for (size_t i = 0; i < n; ++i)
+            ASSERT_EQ(c[i], expected[i]) << "n=" << n << " i=" << i;
+        c.assign(par, a);
+        c.or_assign(par, b);
+        EXPECT_EQ(c.count(), or_count(a, b));
+        c.assign(par, a);
+        c.xor_assign(par, b);
+        EXPECT_EQ(c.count(), xor_count(a, b));
+        c.assign(par, a);
+        c.andnot(par, b);
+        EXPECT_EQ(c.count(), andnot_count(a, b));
+
+        c.assign(par, n, false);
+        EXPECT_EQ(c.size(), n);
+        EXPECT_EQ(c.find_first_one(par), bowen::BitVector<>::npos);
+        EXPECT_EQ(c.find_first_zero(par), n ? 0 : bowen::BitVector<>::npos);
+        if (n) {
+            const size_t pos = n - 1 - rng() % std::min<size_t>(n, 1000);
+            c.set_bit(pos, true);
+            EXPECT_EQ(c.find_first_one(par), pos);
+        }
+        c.assign(par, n, true);
+        EXPECT_EQ(c.count(par), n);
+        EXPECT_EQ(c.find_first_zero(par), bowen::BitVector<>::npos);
+    }
+}
+
+TEST(BitvectorTest, ParallelPoolSharedByConcurrentCallers) {
+    bowen::ThreadPool pool(4);
+    bool ok[4] = {true, true, true, true};
+    auto caller = [&](size_t id, bowen::ParallelPolicy par) {
+        const size_t n = 100003 + id * 4096;
+        bowen::BitVector<> bits;
+        for (int round = 0; round < 50; ++round) {
+            const bool value = (round + id) & 1;
+            bits.assign(par, n, value);
+            if (bits.size() != n || bits.count(par) != (value ? n : 0))
+                ok[id] = false;
+        }
+    };
+    // Two threads on a shared explicit pool with tiny chunks, and two on the
+    // process-wide pool through the default policy.
+    std::thread t0(caller, 0, bowen::ParallelPolicy(pool, 8));
+    std::thread t1(caller, 1, bowen::ParallelPolicy(pool, 8));
+    std::thread t2(caller, 2, bowen::ParallelPolicy());
+    std::thread t3(caller, 3, bowen::ParallelPolicy());
+    t0.join();
+    t1.join();
+    t2.join();
+    t3.join();
+    for (size_t id = 0; id < 4; ++id)
+        EXPECT_TRUE(ok[id]) << "caller " << id;
+}
+
+TEST(BitvectorTest, AtomicBitVectorBasics) {
+    bowen::AtomicBitVector bits(130);
+    EXPECT_EQ(bits.size(), 130u);
+    EXPECT_EQ(bits.word_count(), 3u);
+    EXPECT_FALSE(bits.test_and_set(5));
+    EXPECT_TRUE(bits.test_and_set(5));
+    EXPECT_TRUE(bits.test(5));
+    bits.set(129);
+    EXPECT_TRUE(bits[129]);
+    EXPECT_EQ(bits.count(), 2u);
+    EXPECT_TRUE(bits.test_and_clear(5));
+    EXPECT_FALSE(bits.test_and_clear(5));
+    bits.clear(129);
+    EXPECT_EQ(bits.count(), 0u);
+
+    EXPECT_EQ(bits.fetch_or_word(1, 0xf0), 0u);
+    EXPECT_EQ(bits.fetch_or_word(1, 0x3c), 0xf0u);
+    EXPECT_EQ(bits.load_word(1), 0xfcu);
+    EXPECT_EQ(bits.fetch_and_word(1, 0x0f), 0xfcu);
+    EXPECT_EQ(bits.count(), 2u);
+
+    bowen::BitVector<> plain = bits.to_bitvector();
+    EXPECT_EQ(plain.size(), 130u);
+    EXPECT_TRUE(plain[66]);
+    EXPECT_TRUE(plain[67]);
+    EXPECT_EQ(plain.count(), 2u);
+
+    bowen::AtomicBitVector copy(plain);
+    EXPECT_TRUE(copy.test(67));
+    copy.reset(true);
+    EXPECT_EQ(copy.count(), 130u);
+#ifndef BITVECTOR_NO_BOUND_CHECK
+    EXPECT_THROW(bits.set(130), std::out_of_range);
+    EXPECT_THROW(bits.fetch_or_word(3, 1), std::out_of_range);
+#endif
+}
+
+TEST(BitvectorTest, AtomicBitVectorConcurrentWriters) {
+    const size_t N = 100000;
+    const unsigned threads = 4;
+    bowen::AtomicBitVector bits(N);
+    std::vector<size_t> won(threads);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            // Every thread claims every bit; each bit must be won exactly once.
+            for (size_t i = 0; i < N; ++i) {
+                const size_t pos = (i * 7919 + t * 104729) % N;
+                if (!bits.test_and_set(pos))
+                    ++won[t];
+            }
+        });
+    }
+    for (auto& th : pool)
+        th.join();
+    size_t total = 0;
+    for (size_t w : won)
+        total += w;
+    EXPECT_EQ(total, N);
+    EXPECT_EQ(bits.count(), N);
+}
+
+TEST(BitvectorTest, SpansMatchBitwiseReference) {
+    std::mt19937_64 rng(71);
+    bowen::BitVector<> v(5000);
+    for (size_t i = 0; i < v.size(); ++i)
+        if (rng() % 5 == 0)
+            v.set_bit(i, true);
+    v.set_range(3000, 3700);
+    const size_t npos = bowen::ConstBitSpan::npos;
+    for (int iter = 0; iter < 300; ++iter) {
+        size_t l = rng() % v.size();
+        size_t r = l + rng() % (v.size() - l + 1);
+        if (iter < 4) { // word-aligned and empty spans
+            l = iter * 64;
+            r = iter == 3 ? l : l + 1024;
+        }
+        const bowen::BitVector<>& cv = v;
+        const bowen::ConstBitSpan s = cv.subspan(l, r);
+        const size_t n = r - l;
+        ASSERT_EQ(s.size(), n);
+        EXPECT_EQ(s.count(), v.count(l, r));
+        EXPECT_EQ(s.any(), v.any(l, r));
+        EXPECT_EQ(s.all(), v.all(l, r));
+        const size_t pos = n ? rng() % n : 0;
+        size_t next_one = npos, next_zero = npos, prev_one = npos, prev_zero = npos;
+        for (size_t i = pos; i < n; ++i) {
+            size_t& next = v[l + i] ? next_one : next_zero;
+            if (next == npos)
+                next = i;
+        }
+        for (size_t i = pos; i-- > 0;) {
+            size_t& prev = v[l + i] ? prev_one : prev_zero;
+            if (prev == npos)
+                prev = i;
+        }
+        EXPECT_EQ(s.find_next_one(pos), next_one) << "l=" << l << " r=" << r << " pos=" << pos;
+        EXPECT_EQ(s.find_next_zero(pos), next_zero) << "l=" << l << " r=" << r << " pos=" << pos;
+        EXPECT_EQ(s.find_prev_one(pos), prev_one) << "l=" << l << " r=" << r << " pos=" << pos;
+        EXPECT_EQ(s.find_prev_zero(pos), prev_zero) << "l=" << l << " r=" << r << " pos=" << pos;
+
+        std::vector<uint64_t> ones(s.count());
+        ASSERT_EQ(s.extract_ones(ones.data(), 10), ones.size());
+        for (size_t k = 0; k < ones.size(); ++k)
+            ASSERT_TRUE(v[l + ones[k] - 10]);
+
+        // Realigned copy through the expression leaf.
+        bowen::BitVector<> copy(s);
+        for (size_t i = 0; i < n; ++i)
+            ASSERT_EQ(copy[i], v[l + i]) << "l=" << l << " i=" << i;
+        EXPECT_TRUE(copy == s);
+        EXPECT_EQ((s & copy).count(), s.count());
+        if (n) {
+            copy.flip_range(n - 1, n);
+            EXPECT_TRUE(copy != s);
+        }
+    }
+
+    // Writes through a BitSpan land at the right offset.
+    bowen::BitVector<> w(300), expected(300);
+    bowen::BitSpan ws = w.subspan(37, 250);
+    ws.set_range(10, 150);
+    ws.flip_range(20, 30);
+    ws[200] = true;
+    expected.set_range(47, 187);
+    expected.flip_range(57, 67);
+    expected.set_bit(237, true);
+    EXPECT_TRUE(w == expected);
+#ifndef BITVECTOR_NO_BOUND_CHECK
+    EXPECT_THROW(w.subspan(10, 301), std::out_of_range);
+    EXPECT_THROW(ws.subspan(5, 214), std::out_of_range);
+#endif
+}
+
+TEST(RankSelectTest, MatchesLinearScan) {
+    std::mt19937_64 rng(123);
+    for (size_t n : {0u, 1u, 63u, 64u, 2048u, 5000u, 70001u}) {
+        bowen::BitVector<> bv(n, true);
+        std::vector<size_t> ones, zeros;
+        for (size_t i = 0; i < n; ++i) {
+            bool bit = (rng() % 7) < 2;
+            bv.set_bit(i, bit);
+            (bit ? ones : zeros).push_back(i);
+        }
+        bowen::RankSelect rs(bv);
+        ASSERT_EQ(rs.ones(), ones.size());
+        ASSERT_EQ(rs.zeros(), zeros.size());
+
+        size_t rank = 0;
+        for (size_t i = 0; i <= n; ++i) {
+            ASSERT_EQ(rs.rank1(i), rank) << "n=" << n << " i=" << i;
+            ASSERT_EQ(rs.rank0(i), i - rank);
+            if (i < n)
+                rank += bv[i];
+        }
+        for (size_t k = 0; k < ones.size(); ++k)
+            ASSERT_EQ(rs.select1(k), ones[k]) << "n=" << n << " k=" << k;
+        for (size_t k = 0; k < zeros.size(); ++k)
+            ASSERT_EQ(rs.select0(k), zeros[k]) << "n=" << n << " k=" << k;
+    }
+}
+
+TEST(RankSelectTest, DenseAndSparseExtremes) {
+    const size_t N = 3 * bowen::RankSelect::SELECT_SAMPLE + 100;
+    bowen::BitVector<> dense(N, true);
+    bowen::RankSelect rs_dense(dense);
+    EXPECT_EQ(rs_dense.rank1(N), N);
+    EXPECT_EQ(rs_dense.select1(N - 1), N - 1);
+    EXPECT_EQ(rs_dense.zeros(), 0u);
+
+    bowen::BitVector<> sparse(N);
+    sparse.set_bit(N - 1, true);
+    bowen::RankSelect rs_sparse(sparse);
+    EXPECT_EQ(rs_sparse.select1(0), N - 1);
+    EXPECT_EQ(rs_sparse.select0(N - 2), N - 2);
+
+    // Space overhead stays within the 3-6% budget of the poppy layout.
+    bowen::BitVector<> big(1 << 20, true);
+    bowen::RankSelect rs_big(big);
+    EXPECT_LE(rs_big.index_bytes() * 8 * 100, big.size() * 6);
+}
+
+// Fills chunk c of bv with pattern kind: 0 empty, 1 sparse (array), 2 dense
+// random (bitmap), 3 long runs (run), 4 full.
+static void fill_roaring_chunk(bowen::BitVector<>& bv, size_t c, int kind, std::mt19937_64& rng) {
+    const size_t base = c * bowen::RoaringBitmap::CHUNK_BITS;
+    const size_t end = std::min(bv.size(), base + bowen::RoaringBitmap::CHUNK_BITS);
+    for (size_t i = base; i < end; ++i) {
+        bool bit = false;
+        if (kind == 1)
+            bit = rng() % 100 == 0;
+        else if (kind == 2)
+            bit = rng() % 3 != 0;
+        else if (kind == 3)
+            bit = (i / 1000) % 3 != 0 || (i % 1000) < (c + 1) * 37;
+        else if (kind == 4)
+            bit = true;
+        bv.set_bit(i, bit);
+    }
+}
+
+TEST(RoaringTest, RoundTripAndContainerPairs) {
+    std::mt19937_64 rng(41);
+    const size_t chunks = 5;
+    const size_t N = 4 * bowen::RoaringBitmap::CHUNK_BITS + 12345;
+    // Every container kind of a meets every kind of b in some chunk.
+    for (int shift = 0; shift < 5; ++shift) {
+        bowen::BitVector<> a(N), b(N);
+        for (size_t c = 0; c < chunks; ++c) {
+            fill_roaring_chunk(a, c, static_cast<int>(c), rng);
+            fill_roaring_chunk(b, c, static_cast<int>((c + shift) % 5), rng);
+        }
+        bowen::RoaringBitmap ra(a), rb(b);
+        EXPECT_EQ(ra.cardinality(), a.count());
+        bowen::BitVector<> back = ra.to_bitvector(N);
+        for (size_t i = 0; i < N; ++i)
+            ASSERT_EQ(back[i], a[i]) << "i=" << i;
+
+        bowen::BitVector<> expected_and = a & b;
+        bowen::BitVector<> got_and = (ra & rb).to_bitvector(N);
+        EXPECT_EQ((ra & rb).cardinality(), expected_and.count());
+        for (size_t i = 0; i < N; ++i)
+            ASSERT_EQ(got_and[i], expected_and[i]) << "shift=" << shift << " i=" << i;
+
+        bowen::BitVector<> expected_or = a | b;
+        bowen::RoaringBitmap ror = ra;
+        ror |= rb;
+        EXPECT_EQ(ror.cardinality(), expected_or.count());
+        bowen::BitVector<> got_or = ror.to_bitvector(N);
+        for (size_t i = 0; i < N; ++i)
+            ASSERT_EQ(got_or[i], expected_or[i]) << "shift=" << shift << " i=" << i;
+    }
+}
+
+TEST(RoaringTest, ArrayIntersectionsAndUnions) {
+    std::mt19937_64 rng(43);
+    for (size_t density : {2u, 50u, 300u}) {
+        bowen::BitVector<> a(1 << 16), b(1 << 16);
+        for (size_t i = 0; i < a.size(); ++i) {
+            a.set_bit(i, rng() % 1000 < density);
+            b.set_bit(i, rng() % 1000 < density);
+        }
+        bowen::RoaringBitmap ra(a), rb(b);
+        bowen::BitVector<> both = a & b;
+        bowen::BitVector<> either = a | b;
+        EXPECT_EQ((ra & rb).to_bitvector(a.size()).count(), both.count());
+        EXPECT_EQ((ra & rb).cardinality(), both.count());
+        EXPECT_EQ((ra | rb).cardinality(), either.count());
+        EXPECT_EQ(xor_count((ra | rb).to_bitvector(a.size()), either), 0u);
+    }
+}
+
+TEST(RoaringTest, AddRemoveContains) {
+    bowen::RoaringBitmap r;
+    EXPECT_TRUE(r.empty());
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < 10000; ++i)
+        values.push_back(i * 7);
+    values.push_back(0xffffffffu);
+    for (uint32_t v : values)
+        r.add(v);
+    r.add(70);
+    EXPECT_EQ(r.cardinality(), values.size());
+    EXPECT_EQ(r.maximum(), 0xffffffffu);
+    for (uint32_t v : values)
+        ASSERT_TRUE(r.contains(v));
+    EXPECT_FALSE(r.contains(71));
+    r.remove(70);
+    r.remove(71);
+    EXPECT_FALSE(r.contains(70));
+    EXPECT_EQ(r.cardinality(), values.size() - 1);
+
+    bowen::BitVector<> runs(200000);
+    runs.set_range(1000, 150000);
+    bowen::RoaringBitmap rr(runs);
+    EXPECT_LT(rr.memory_bytes(), 1024u);
+    rr.add(999);
+    rr.remove(1000);
+    EXPECT_TRUE(rr.contains(999));
+    EXPECT_FALSE(rr.contains(1000));
+    EXPECT_TRUE(rr.contains(149999));
+    EXPECT_EQ(rr.cardinality(), 149000u);
+    rr.run_optimize();
+    EXPECT_EQ(rr.cardinality(), 149000u);
+    EXPECT_EQ(rr.to_bitvector(200000).count(999, 150001), 149000u);
+#ifndef BITVECTOR_NO_BOUND_CHECK
+    EXPECT_THROW(rr.to_bitvector(1000), std::out_of_range);
+#endif
+}
+
+// Runs of random length and value, with a sprinkling of dirty words.
+static bowen::BitVector<> run_heavy_bits(size_t n, std::mt19937_64& rng) {
+    bowen::BitVector<> bv(n);
+    size_t i = 0;
+    bool value = rng() & 1;
+    while (i < n) {
+        const size_t len = 1 + rng() % 3000;
+        const size_t end = std::min(n, i + len);
+        if (value)
+            bv.set_range(i, end);
+        i = end;
+        value = !value;
+    }
+    for (size_t k = 0; k < n / 500; ++k)
+        bv.set_bit(rng() % n, rng() & 1);
+    return bv;
+}
+
+TEST(EwahTest, RoundTripAndCount) {
+    std::mt19937_64 rng(47);
+    for (size_t n : {0u, 1u, 63u, 64u, 65u, 1000u, 64u * 1000u, 100003u}) {
+        bowen::BitVector<> bv = run_heavy_bits(n, rng);
+        bowen::EwahBitmap e(bv);
+        EXPECT_EQ(e.size(), n);
+        EXPECT_EQ(e.count(), bv.count()) << "n=" << n;
+        bowen::BitVector<> back = e.to_bitvector();
+        EXPECT_EQ(back.size(), n);
+        for (size_t i = 0; i < n; ++i)
+            ASSERT_EQ(back[i], bv[i]) << "n=" << n << " i=" << i;
+    }
+
+    bowen::BitVector<> ones(64 * 100000, true);
+    bowen::EwahBitmap e(ones);
+    EXPECT_EQ(e.buffer_words(), 1u);
+    EXPECT_EQ(e.count(), ones.size());
+}
+
+TEST(EwahTest, LogicalOpsMatchFlat) {
+    std::mt19937_64 rng(53);
+    for (size_t n : {1u, 130u, 64u * 5000u, 300007u}) {
+        bowen::BitVector<> a = run_heavy_bits(n, rng);
+        bowen::BitVector<> b = run_heavy_bits(n, rng);
+        bowen::EwahBitmap ea(a), eb(b);
+        bowen::BitVector<> expected_and = a & b;
+        bowen::BitVector<> expected_or = a | b;
+        bowen::BitVector<> expected_xor = a ^ b;
+        bowen::EwahBitmap e_and = ea & eb, e_or = ea | eb, e_xor = ea ^ eb;
+        EXPECT_EQ(e_and.count(), expected_and.count());
+        EXPECT_EQ(e_or.count(), expected_or.count());
+        EXPECT_EQ(e_xor.count(), expected_xor.count());
+        bowen::BitVector<> got_and = e_and.to_bitvector();
+        bowen::BitVector<> got_or = e_or.to_bitvector();
+        bowen::BitVector<> got_xor = e_xor.to_bitvector();
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(got_and[i], expected_and[i]) << "n=" << n << " i=" << i;
+            ASSERT_EQ(got_or[i], expected_or[i]) << "n=" << n << " i=" << i;
+            ASSERT_EQ(got_xor[i], expected_xor[i]) << "n=" << n << " i=" << i;
+        }
+        // Results are re-compressed, so an op on two run-heavy inputs stays small.
+        EXPECT_LE(e_and.compressed_bytes(), ea.compressed_bytes() + eb.compressed_bytes());
+    }
+#ifndef BITVECTOR_NO_BOUND_CHECK
+    bowen::EwahBitmap small(bowen::BitVector<>(10)), large(bowen::BitVector<>(20));
+    EXPECT_THROW(small & large, std::invalid_argument);
+#endif
+}
+
+TEST(MappedTest, CreateSyncReopen) {
+    const std::string path = ::testing::TempDir() + "bitvector_mapped_test.bv";
+    const size_t n = 100003;
+    {
+        bowen::MappedBitVector bits = bowen::create_mapped_bitvector(path, n);
+        ASSERT_NE(bits.get_allocator().file(), nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(bits.data()) % 64, 0u);
+        for (size_t i = 0; i < n; i += 7)
+            bits.set_bit(i, true);
+        bowen::advise(bits, bowen::MapAccess::Sequential);
+        bowen::sync(bits);
+    }
+    {
+        const bowen::MappedBitVector bits = bowen::open_mapped_bitvector(path, bowen::MapMode::ReadOnly);
+        ASSERT_EQ(bits.size(), n);
+        EXPECT_EQ(bits.count(), (n + 6) / 7);
+        for (size_t i = 0; i < 100; ++i)
+            EXPECT_EQ(bits[i], i % 7 == 0) << "i=" << i;
+        // Copies are plain in-memory vectors and can be written.
+        bowen::MappedBitVector copy(bits);
+        EXPECT_EQ(copy.get_allocator().file(), nullptr);
+        copy.set_bit(1, true);
+        EXPECT_EQ(copy.count(), bits.count() + 1);
+    }
+    {
+        // Writes through a read-only mapping are private to this process.
+        bowen::MappedBitVector bits = bowen::open_mapped_bitvector(path, bowen::MapMode::ReadOnly);
+        bits.set_bit(1, true);
+        bits.flip();
+        EXPECT_EQ(bits.count(), n - (n + 6) / 7 - 1);
+        EXPECT_THROW(bits.reserve(2 * n), std::runtime_error);
+    }
+    {
+        const bowen::MappedBitVector bits = bowen::open_mapped_bitvector(path, bowen::MapMode::ReadOnly);
+        EXPECT_EQ(bits.count(), (n + 6) / 7);
+        EXPECT_FALSE(bits[1]);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(MappedTest, GrowsThroughPushBack) {
+    const std::string path = ::testing::TempDir() + "bitvector_mapped_grow.bv";
+    std::vector<bool> expected;
+    {
+        bowen::MappedBitVector bits = bowen::create_mapped_bitvector(path, 0);
+        for (size_t i = 0; i < 50000; ++i) {
+            const bool v = (i * 2654435761u) & 0x100;
+            bits.push_back(v);
+            expected.push_back(v);
+        }
+        bowen::MappedBitVector other(bits.size(), true);
+        bits &= other;
+        const bowen::MappedBitVector copy = bits;
+        EXPECT_EQ(copy.get_allocator().file(), nullptr);
+        EXPECT_TRUE(copy == bits);
+        // The file holds one vector; a second allocation from it must not
+        // alias the first.
+        EXPECT_THROW(bowen::MappedBitVector(10, false, bits.get_allocator()), std::runtime_error);
+        EXPECT_TRUE(copy == bits);
+        bowen::sync(bits);
+    }
+    bowen::MappedBitVector bits = bowen::open_mapped_bitvector(path);
+    ASSERT_EQ(bits.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+        ASSERT_EQ(bits[i], expected[i]) << "i=" << i;
+    bits.push_back(true);
+    EXPECT_TRUE(bits[expected.size()]);
+    bits.shrink_to_fit();
+    EXPECT_TRUE(bits[expected.size()]);
+    const bowen::MappedBitVector wide(70000, true);
+    bits = wide & wide; // grows inside the file
+    EXPECT_EQ(bits.count(), 70000u);
+    EXPECT_EQ(bits.get_allocator().file()->capacity_words(), (70000u + 63) / 64);
+    std::remove(path.c_str());
+    EXPECT_THROW(bowen::open_mapped_bitvector(path), std::system_error);
+}
+
+TEST(SerializeTest, Crc32cKnownValuesAndChaining) {
+    EXPECT_EQ(bowen::crc32c("123456789", 9), 0xe3069283u);
+    EXPECT_EQ(bowen::crc32c("", 0), 0u);
+    // Long inputs take the three-lane path; pieces below 12 KiB do not.
+    std::vector<unsigned char> buf(100003);
+    std::mt19937_64 rng(61);
+    for (auto& b : buf)
+        b = static_cast<unsigned char>(rng());
+    uint32_t chained = 0;
+    for (size_t off = 0; off < buf.size(); off += 1001)
+        chained = bowen::crc32c(buf.data() + off, std::min<size_t>(1001, buf.size() - off), chained);
+    EXPECT_EQ(bowen::crc32c(buf.data(), buf.size()), chained);
+}
+
+// Saves `bits` to a temporary file and reads the file back.
+static std::vector<uint64_t> save_and_read(const bowen::BitVector<>& bits, uint32_t flags) {
+    const std::string path = ::testing::TempDir() + "bitvector_serialize_test.bin";
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    EXPECT_GE(fd, 0);
+    bowen::save(fd, bits, flags);
+    const off_t bytes = ::lseek(fd, 0, SEEK_END);
+    std::vector<uint64_t> buf(bytes / sizeof(uint64_t));
+    EXPECT_EQ(::pread(fd, buf.data(), bytes, 0), bytes);
+    ::close(fd);
+    std::remove(path.c_str());
+    return buf;
+}
+
+TEST(SerializeTest, RoundTripViews) {
+    std::mt19937_64 rng(67);
+    for (size_t n : {0u, 1u, 64u, 2048u, 2049u, 100003u}) {
+        bowen::BitVector<> bits(n);
+        for (size_t i = 0; i < n; ++i)
+            if (rng() & 1)
+                bits.set_bit(i, true);
+        if (n % 64)
+            bits.data()[n / 64] |= ~bowen::detail::tail_mask(n); // garbage past size()
+        for (uint32_t flags : {0u, bowen::SerialFormat::POPCOUNT, bowen::SerialFormat::POPCOUNT | bowen::SerialFormat::RANK}) {
+            const std::vector<uint64_t> buf = save_and_read(bits, flags);
+            const bowen::BitVectorView view = bowen::load_view(buf.data(), buf.size() * sizeof(uint64_t));
+            ASSERT_EQ(view.size(), n);
+            EXPECT_EQ(view.serialized_bytes(), buf.size() * sizeof(uint64_t));
+            EXPECT_EQ(view.has_popcount(), (flags & bowen::SerialFormat::POPCOUNT) != 0);
+            EXPECT_EQ(view.has_rank(), (flags & bowen::SerialFormat::RANK) != 0);
+            EXPECT_EQ(view.count(), bits.count()) << "n=" << n << " flags=" << flags;
+            size_t ones = 0;
+            for (size_t i = 0; i < n; ++i) {
+                ASSERT_EQ(view.rank1(i), ones) << "n=" << n << " i=" << i;
+                ASSERT_EQ(view[i], bits[i]);
+                ones += bits[i];
+            }
+            EXPECT_EQ(view.rank1(n), ones);
+            EXPECT_EQ(bowen::BitVector<>(view.expr() & bits).count(), ones);
+            EXPECT_EQ(view.to_bitvector().count(), ones);
+        }
+    }
+}
+
+TEST(SerializeTest, RejectsDamagedBuffers) {
+    bowen::BitVector<> bits(5000, true);
+    std::vector<uint64_t> buf = save_and_read(bits, bowen::SerialFormat::POPCOUNT);
+    const size_t bytes = buf.size() * sizeof(uint64_t);
+    EXPECT_THROW(bowen::load_view(buf.data(), bytes - 64), std::runtime_error);
+    buf[20] ^= 1; // payload bit
+    EXPECT_THROW(bowen::load_view(buf.data(), bytes), std::runtime_error);
+    const bowen::BitVectorView unchecked = bowen::load_view(buf.data(), bytes, false);
+    EXPECT_FALSE(unchecked.verify());
+    buf[2] ^= 1; // bit count in the header
+    EXPECT_THROW(bowen::load_view(buf.data(), bytes, false), std::runtime_error);
+
+    // A huge bit count with a consistent-looking header: the payload size
+    // must not wrap around to zero.
+    std::vector<uint64_t> forged(buf.begin(), buf.begin() + 8);
+    forged[2] = ~uint64_t(0); // bits
+    forged[4] = 0;            // payload_bytes
+    forged[5] = 0;            // rank_bytes
+    const uint32_t header_crc = bowen::crc32c(forged.data(), 60);
+    std::memcpy(reinterpret_cast<char*>(forged.data()) + 60, &header_crc, sizeof(header_crc));
+    EXPECT_THROW(bowen::load_view(forged.data(), 64, false), std::runtime_error);
+    EXPECT_THROW(bowen::load_view(forged.data(), 64), std::runtime_error);
+}
+
+constexpr bowen::BitArray<300> make_mask() {
+    bowen::BitArray<300> mask;
+    mask.set_range(60, 130);
+    mask.set_bit(299);
+    return mask;
+}
+
+TEST(BitArrayTest, ConstexprQueries) {
+    constexpr bowen::BitArray<300> mask = make_mask();
+    static_assert(mask.count() == 71, "count");
+    static_assert(mask.find_first_one() == 60 && mask.find_last_one() == 299, "find");
+    static_assert(mask.find_next_zero(60) == 130 && mask.find_prev_one(299) == 129, "find");
+    static_assert((~mask).count() == 229 && !(~bowen::BitArray<300>()).none(), "flip");
+    static_assert(bowen::BitArray<300>(true).all() && !mask.all(), "all");
+    static_assert((mask & ~mask).none() && (mask | ~mask).all(), "bitwise");
+    EXPECT_EQ(mask.find_next_one(300), bowen::BitArray<300>::npos);
+}
+
+template<std::size_t N>
+void check_bit_array_against_bitset(uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    bowen::BitArray<N> a, b;
+    std::bitset<N> ra, rb;
+    for (size_t i = 0; i < N; ++i) {
+        const bool x = (rng() & 3) == 0, y = (rng() & 1) == 0;
+        a.set_bit(i, x);
+        b[i] = y;
+        ra[i] = x;
+        rb[i] = y;
+    }
+    const auto same = [](const bowen::BitArray<N>& v, const std::bitset<N>& r) {
+        for (size_t i = 0; i < N; ++i)
+            if (v[i] != r[i])
+                return false;
+        return v.count() == r.count() && v.all() == r.all() && v.any() == r.any();
+    };
+    EXPECT_TRUE(same(a & b, ra & rb));
+    EXPECT_TRUE(same(a | b, ra | rb));
+    EXPECT_TRUE(same(a ^ b, ra ^ rb));
+    EXPECT_TRUE(same(~a, ~ra));
+    EXPECT_TRUE(same(bowen::BitArray<N>(a).andnot(b), ra & ~rb));
+    std::bitset<N> middle;
+    for (size_t i = N / 3; i < N - N / 3; ++i)
+        middle[i] = true;
+    EXPECT_TRUE(same(bowen::BitArray<N>(a).flip_range(N / 3, N - N / 3), ra ^ middle));
+    EXPECT_TRUE(same(bowen::BitArray<N>(a).clear_range(N / 3, N - N / 3), ra & ~middle));
+    for (size_t pos = 0; pos <= N; pos += 7) {
+        size_t next = pos;
+        while (next < N && !ra[next])
+            ++next;
+        EXPECT_EQ(a.find_next_one(pos), next < N ? next : bowen::BitArray<N>::npos);
+        size_t prev = pos;
+        while (prev > 0 && ra[prev - 1])
+            --prev;
+        EXPECT_EQ(a.find_prev_zero(pos), prev > 0 ? prev - 1 : bowen::BitArray<N>::npos);
+    }
+
+    const bowen::BitVector<> v = a.to_bitvector();
+    EXPECT_EQ(v.size(), N);
+    EXPECT_EQ(v.count(), a.count());
+    EXPECT_TRUE(bowen::BitArray<N>(v) == a);
+#ifndef BITVECTOR_NO_BOUND_CHECK
+    EXPECT_THROW(bowen::BitArray<N>(bowen::BitVector<>(N + 1)), std::invalid_argument);
+    EXPECT_THROW(a.set_bit(N), std::out_of_range);
+#endif
+}
+
+TEST(BitArrayTest, MatchesBitset) {
+    check_bit_array_against_bitset<1>(1);
+    check_bit_array_against_bitset<64>(2);
+    check_bit_array_against_bitset<100>(3);
+    check_bit_array_against_bitset<1024>(4);
+    check_bit_array_against_bitset<4000>(5);
+}
+
+TEST(ArenaTest, BumpAllocationResetAndReuse) {
+    bowen::BitArena arena(4096);
+    bowen::ArenaAllocator<bowen::BitType> alloc(arena);
+    bowen::BitType* a = alloc.allocate(3);
+    bowen::BitType* b = alloc.allocate(5);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<char*>(b), reinterpret_cast<char*>(a) + 64);
+
+    // Freeing the newest allocation rolls the pointer back; older ones stay.
+    alloc.deallocate(b, 5);
+    EXPECT_EQ(alloc.allocate(5), b);
+    alloc.deallocate(a, 3);
+    EXPECT_EQ(arena.bytes_used(), 64u + 40u);
+
+    // Allocations larger than a block get a block of their own.
+    bowen::BitType* big = alloc.allocate(1000);
+    big[999] = 1;
+    EXPECT_EQ(arena.bytes_reserved(), 4096u + 8000u + 64u);
+
+    arena.reset();
+    EXPECT_EQ(arena.bytes_used(), 0u);
+    EXPECT_EQ(alloc.allocate(3), a);
+    EXPECT_EQ(alloc.allocate(1000), big); // the retained large block is reused
+    EXPECT_EQ(arena.bytes_reserved(), 4096u + 8000u + 64u);
+}
+
+TEST(ArenaTest, BitVectorsOnThreadArenas) {
+    typedef bowen::BitVector<bowen::ArenaAllocator<bowen::BitType>> ArenaBitVector;
+    bowen::BitArena& arena = bowen::BitArena::local();
+    arena.reset();
+    bowen::BitVector<> a(5000), b(5000);
+    for (size_t i = 0; i < 5000; i += 3)
+        a.set_bit(i, true);
+    for (size_t i = 0; i < 5000; i += 5)
+        b.set_bit(i, true);
+    {
+        ArenaBitVector both = a & b;
+        ArenaBitVector either = a | b;
+        EXPECT_EQ(both.count(), and_count(a, b));
+        EXPECT_EQ(either.count(), or_count(a, b));
+        either.push_back(true);
+        EXPECT_TRUE(either[5000]);
+        EXPECT_EQ(&both.get_allocator().arena(), &arena);
+    }
+    arena.reset();
+
+    bowen::BitArena* other = nullptr;
+    std::thread t([&other] { other = &bowen::BitArena::local(); });
+    t.join();
+    EXPECT_NE(other, &arena);
+}
+
+TEST(HugePageTest, AlignedMappingsAndParallelFill) {
+    bowen::HugePageAllocator<bowen::BitType> alloc;
+    const size_t huge_words = bowen::HugePageAllocator<bowen::BitType>::HUGE_PAGE_BYTES / sizeof(bowen::BitType);
+    bowen::BitType* big = alloc.allocate(huge_words + 1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % (2u << 20), 0u);
+    big[0] = 1;
+    big[2 * huge_words - 1] = 1; // the block is rounded up to whole huge pages
+    alloc.deallocate(big, huge_words + 1);
+    bowen::BitType* small = alloc.allocate(10);
+    small[9] = 1;
+    alloc.deallocate(small, 10);
+
+    // Reserved falls back to transparent pages when vm.nr_hugepages is 0.
+    bowen::ThreadPool pool(3);
+    for (bowen::HugePageMode mode : {bowen::HugePageMode::Transparent, bowen::HugePageMode::Reserved}) {
+        const size_t n = 40000000; // several huge pages and a partial one
+        bowen::HugePageBitVector bits = bowen::make_hugepage_bitvector(n, true, mode, pool);
+        EXPECT_EQ(bits.size(), n);
+        EXPECT_EQ(bits.count(), n);
+        bits.set_bit(n - 1, false);
+        EXPECT_EQ(bits.find_first_zero(), n - 1);
+        bowen::HugePageBitVector copy = bits;
+        EXPECT_TRUE(copy == bits);
+    }
+    EXPECT_EQ(bowen::make_hugepage_bitvector(1000, false, bowen::HugePageMode::Transparent, pool).count(), 0u);
+}
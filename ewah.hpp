@@ -0,0 +1,326 @@
+#ifndef BITVECTOR_EWAH_H
+#define BITVECTOR_EWAH_H
+
+#include "bitvector.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace bowen
+{
+    // Word-aligned run-length compressed bitmap (EWAH, Lemire, Kaser, Aouiche
+    // 2010).  The bits are cut into 64-bit words and stored as a stream of
+    // marker words, each followed by its literal words:
+    //
+    //   bit 0       value of the clean run (all zeros or all ones)
+    //   bits 1-32   number of clean words in the run
+    //   bits 33-63  number of literal (dirty) words stored after the marker
+    //
+    // AND, OR and XOR stream over both operands without decompressing.  A
+    // clean run is consumed in one step: against a run of zeros (AND) or
+    // ones (OR) the other operand's words are skipped marker by marker, and
+    // only literal words ever reach the word-by-word loop.
+    //
+    // Bits past size() are always zero.
+    class EwahBitmap
+    {
+    public:
+        static constexpr uint64_t RUN_MAX = 0xffffffffu;
+        static constexpr uint64_t LITERALS_MAX = 0x7fffffffu;
+
+    private:
+        std::vector<BitType> m_buffer;
+        size_t m_size;
+        size_t m_last_marker; // index of the last marker in m_buffer
+
+        static size_t num_words(size_t bits)
+        {
+            return (bits + WORD_BITS - 1) / WORD_BITS;
+        }
+
+        static bool marker_bit(BitType m)
+        {
+            return m & 1;
+        }
+
+        static uint64_t marker_run(BitType m)
+        {
+            return (m >> 1) & RUN_MAX;
+        }
+
+        static uint64_t marker_literals(BitType m)
+        {
+            return m >> 33;
+        }
+
+        static BitType make_marker(bool bit, uint64_t run, uint64_t literals)
+        {
+            return static_cast<BitType>(bit) | (static_cast<BitType>(run) << 1) | (static_cast<BitType>(literals) << 33);
+        }
+
+        void append_run(bool bit, uint64_t n)
+        {
+            if (!n)
+                return;
+            if (!m_buffer.empty()) {
+                BitType& m = m_buffer[m_last_marker];
+                if (marker_literals(m) == 0 && (marker_run(m) == 0 || marker_bit(m) == bit)) {
+                    const uint64_t take = std::min(n, RUN_MAX - marker_run(m));
+                    m = make_marker(bit, marker_run(m) + take, 0);
+                    n -= take;
+                }
+            }
+            while (n) {
+                const uint64_t take = std::min(n, RUN_MAX);
+                m_last_marker = m_buffer.size();
+                m_buffer.push_back(make_marker(bit, take, 0));
+                n -= take;
+            }
+        }
+
+        void append_literal(BitType w)
+        {
+            if (w == 0 || w == ~static_cast<BitType>(0)) {
+                append_run(w != 0, 1);
+                return;
+            }
+            if (m_buffer.empty() || marker_literals(m_buffer[m_last_marker]) == LITERALS_MAX) {
+                m_last_marker = m_buffer.size();
+                m_buffer.push_back(make_marker(false, 0, 0));
+            }
+            m_buffer[m_last_marker] += static_cast<BitType>(1) << 33;
+            m_buffer.push_back(w);
+        }
+
+        // Read position in a compressed stream: the rest of the current
+        // clean run, then the rest of the current literal block.
+        struct Cursor {
+            const BitType* next;
+            const BitType* end;
+            bool bit = false;
+            uint64_t run = 0;
+            uint64_t literals = 0;
+            const BitType* literal = nullptr;
+
+            explicit Cursor(const std::vector<BitType>& buffer)
+                : next(buffer.data()), end(buffer.data() + buffer.size())
+            {
+                load();
+            }
+
+            // Steps over exhausted markers.
+            void load()
+            {
+                while (run == 0 && literals == 0 && next != end) {
+                    const BitType m = *next++;
+                    bit = marker_bit(m);
+                    run = marker_run(m);
+                    literals = marker_literals(m);
+                    literal = next;
+                    next += literals;
+                }
+            }
+
+            bool done() const
+            {
+                return run == 0 && literals == 0;
+            }
+
+            void skip_run(uint64_t n)
+            {
+                run -= n;
+                if (!run && !literals)
+                    load();
+            }
+
+            void skip_literals(uint64_t n)
+            {
+                literal += n;
+                literals -= n;
+                if (!literals)
+                    load();
+            }
+        };
+
+        // What a clean run of one operand makes of the other operand's words.
+        enum class RunEffect { Zeros, Ones, Copy, Negate };
+
+        struct and_rule {
+            static RunEffect effect(bool bit) { return bit ? RunEffect::Copy : RunEffect::Zeros; }
+            static BitType apply(BitType a, BitType b) { return a & b; }
+        };
+
+        struct or_rule {
+            static RunEffect effect(bool bit) { return bit ? RunEffect::Ones : RunEffect::Copy; }
+            static BitType apply(BitType a, BitType b) { return a | b; }
+        };
+
+        // A run of ones can only cover the last word when size() is a
+        // multiple of 64, so negating under it never sets bits past size().
+        struct xor_rule {
+            static RunEffect effect(bool bit) { return bit ? RunEffect::Negate : RunEffect::Copy; }
+            static BitType apply(BitType a, BitType b) { return a ^ b; }
+        };
+
+        // Consumes n words of `c` and appends what `effect` makes of them.
+        // Constant effects skip whole runs and literal blocks in one step.
+        void consume(Cursor& c, uint64_t n, RunEffect effect)
+        {
+            while (n) {
+                if (c.run) {
+                    const uint64_t k = std::min(n, c.run);
+                    if (effect == RunEffect::Zeros || effect == RunEffect::Ones)
+                        append_run(effect == RunEffect::Ones, k);
+                    else
+                        append_run(c.bit != (effect == RunEffect::Negate), k);
+                    c.skip_run(k);
+                    n -= k;
+                } else {
+                    const uint64_t k = std::min(n, c.literals);
+                    if (effect == RunEffect::Zeros || effect == RunEffect::Ones) {
+                        append_run(effect == RunEffect::Ones, k);
+                    } else {
+                        const BitType invert = effect == RunEffect::Negate ? ~static_cast<BitType>(0) : 0;
+                        for (uint64_t i = 0; i < k; ++i)
+                            append_literal(c.literal[i] ^ invert);
+                    }
+                    c.skip_literals(k);
+                    n -= k;
+                }
+            }
+        }
+
+        template<typename Rule>
+        static EwahBitmap combine(const EwahBitmap& a, const EwahBitmap& b)
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (a.m_size != b.m_size){
+                std::stringstream  ss;
+                ss << "EwahBitmap size mismatch" << " lhs: " << a.m_size << " rhs: " << b.m_size << std::endl;
+                throw std::invalid_argument(ss.str());
+            }
+#endif
+            EwahBitmap out;
+            out.m_size = a.m_size;
+            out.m_buffer.reserve(std::max(a.m_buffer.size(), b.m_buffer.size()));
+            Cursor i(a.m_buffer), j(b.m_buffer);
+            while (!i.done() && !j.done()) {
+                if (i.run || j.run) {
+                    // The longer run decides what happens to the other side.
+                    Cursor& runner = i.run >= j.run ? i : j;
+                    Cursor& other = &runner == &i ? j : i;
+                    const uint64_t n = runner.run;
+                    out.consume(other, n, Rule::effect(runner.bit));
+                    runner.skip_run(n);
+                } else {
+                    const uint64_t n = std::min(i.literals, j.literals);
+                    for (uint64_t k = 0; k < n; ++k)
+                        out.append_literal(Rule::apply(i.literal[k], j.literal[k]));
+                    i.skip_literals(n);
+                    j.skip_literals(n);
+                }
+            }
+            return out;
+        }
+
+    public:
+        EwahBitmap()
+            : m_size(0), m_last_marker(0) {}
+
+        template<typename Allocator, std::size_t InlineBits>
+        explicit EwahBitmap(const BitVector<Allocator, InlineBits>& bits)
+            : m_size(bits.size()), m_last_marker(0)
+        {
+            const BitType* data = bits.data();
+            const size_t words = num_words(m_size);
+            for (size_t i = 0; i < words; ++i) {
+                BitType w = data[i];
+                if (i + 1 == words)
+                    w &= detail::tail_mask(m_size);
+                if (w == 0 || w == ~static_cast<BitType>(0)) {
+                    // Extend over the whole clean stretch at once.
+                    size_t end = i + 1;
+                    const size_t limit = (m_size & (WORD_BITS - 1)) ? words - 1 : words;
+                    while (end < limit && data[end] == w)
+                        ++end;
+                    append_run(w != 0, end - i);
+                    i = end - 1;
+                } else {
+                    append_literal(w);
+                }
+            }
+        }
+
+        template<typename Allocator = std::allocator<BitType>>
+        BitVector<Allocator> to_bitvector() const
+        {
+            BitVector<Allocator> out(m_size);
+            BitType* dst = out.data();
+            Cursor c(m_buffer);
+            while (!c.done()) {
+                if (c.run) {
+                    if (c.bit)
+                        std::fill(dst, dst + c.run, ~static_cast<BitType>(0));
+                    dst += c.run;
+                    c.skip_run(c.run);
+                } else {
+                    dst = std::copy(c.literal, c.literal + c.literals, dst);
+                    c.skip_literals(c.literals);
+                }
+            }
+            return out;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        // Number of set bits, without decompressing.
+        size_t count() const
+        {
+            size_t total = 0;
+            Cursor c(m_buffer);
+            while (!c.done()) {
+                if (c.run) {
+                    total += c.bit ? c.run * WORD_BITS : 0;
+                    c.skip_run(c.run);
+                } else {
+                    total += detail::popcount_kernel(detail::word_source<>{c.literal}, c.literals);
+                    c.skip_literals(c.literals);
+                }
+            }
+            return total;
+        }
+
+        // Bytes of the compressed stream.
+        size_t compressed_bytes() const
+        {
+            return m_buffer.size() * sizeof(BitType);
+        }
+
+        // Number of marker plus literal words in the stream.
+        size_t buffer_words() const
+        {
+            return m_buffer.size();
+        }
+
+        friend EwahBitmap operator&(const EwahBitmap& a, const EwahBitmap& b)
+        {
+            return combine<and_rule>(a, b);
+        }
+
+        friend EwahBitmap operator|(const EwahBitmap& a, const EwahBitmap& b)
+        {
+            return combine<or_rule>(a, b);
+        }
+
+        friend EwahBitmap operator^(const EwahBitmap& a, const EwahBitmap& b)
+        {
+            return combine<xor_rule>(a, b);
+        }
+    };
+
+} // namespace bowen
+
+#endif
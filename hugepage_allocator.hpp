@@ -0,0 +1,166 @@
+#ifndef BITVECTOR_HUGEPAGE_ALLOCATOR_H
+#define BITVECTOR_HUGEPAGE_ALLOCATOR_H
+
+#include "bitvector.hpp"
+#include "parallel.hpp"
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+
+namespace bowen
+{
+    enum class HugePageMode {
+        // madvise(MADV_HUGEPAGE) on a 2 MB aligned mapping; the kernel backs
+        // it with transparent huge pages when it can.
+        Transparent,
+        // MAP_HUGETLB from the reserved pool (vm.nr_hugepages), falling back
+        // to Transparent when the pool cannot satisfy the request.
+        Reserved
+    };
+
+    // Allocator for large BitVectors backed by 2 MB pages, so random access
+    // over 10^9 bits needs one TLB entry per 2 MB instead of per 4 KB.
+    // Blocks of at least HUGE_PAGE_BYTES are mapped 2 MB aligned and rounded
+    // up to whole huge pages; smaller blocks get ordinary pages.  When huge
+    // pages are unavailable (THP disabled, no reserved pages, not Linux) the
+    // mapping silently uses ordinary pages.
+    //
+    // The pages are not touched by allocate().  make_hugepage_bitvector()
+    // fills them from a thread pool so that each page is first touched, and
+    // therefore placed, on the NUMA node of the thread that fills it.
+    template<typename T>
+    class HugePageAllocator
+    {
+    public:
+        static constexpr std::size_t HUGE_PAGE_BYTES = std::size_t(2) << 20;
+
+    private:
+        static constexpr std::size_t PAGE_BYTES = 4096;
+
+        HugePageMode m_mode;
+
+        template<typename U>
+        friend class HugePageAllocator;
+
+        static std::size_t mapping_bytes(std::size_t n)
+        {
+            const std::size_t bytes = n ? n * sizeof(T) : 1;
+            const std::size_t page = bytes >= HUGE_PAGE_BYTES ? HUGE_PAGE_BYTES : PAGE_BYTES;
+            return (bytes + page - 1) / page * page;
+        }
+
+        static void* map(std::size_t bytes, int extra_flags)
+        {
+            void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+            return p == MAP_FAILED ? nullptr : p;
+        }
+
+        // Maps `bytes` at a 2 MB boundary by over-mapping one huge page and
+        // unmapping the slack on both sides.
+        static void* map_aligned(std::size_t bytes)
+        {
+            char* raw = static_cast<char*>(map(bytes + HUGE_PAGE_BYTES, 0));
+            if (!raw)
+                return nullptr;
+            const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(raw);
+            char* p = reinterpret_cast<char*>((base + HUGE_PAGE_BYTES - 1) & ~static_cast<std::uintptr_t>(HUGE_PAGE_BYTES - 1));
+            const std::size_t head = static_cast<std::size_t>(p - raw);
+            if (head)
+                ::munmap(raw, head);
+            if (HUGE_PAGE_BYTES - head)
+                ::munmap(p + bytes, HUGE_PAGE_BYTES - head);
+            return p;
+        }
+
+    public:
+        typedef T value_type;
+        typedef std::true_type is_always_equal;
+
+        explicit HugePageAllocator(HugePageMode mode = HugePageMode::Transparent) noexcept
+            : m_mode(mode) {}
+
+        template<typename U>
+        HugePageAllocator(const HugePageAllocator<U>& other) noexcept
+            : m_mode(other.m_mode) {}
+
+        HugePageMode mode() const
+        {
+            return m_mode;
+        }
+
+        T* allocate(std::size_t n)
+        {
+            if (n > (std::numeric_limits<std::size_t>::max() - 2 * HUGE_PAGE_BYTES) / sizeof(T)) {
+                throw std::bad_alloc();
+            }
+            const std::size_t bytes = mapping_bytes(n);
+            void* p = nullptr;
+            if (bytes < HUGE_PAGE_BYTES) {
+                p = map(bytes, 0);
+            } else {
+#ifdef MAP_HUGETLB
+                if (m_mode == HugePageMode::Reserved)
+                    p = map(bytes, MAP_HUGETLB);
+#endif
+                if (!p) {
+                    p = map_aligned(bytes);
+#ifdef MADV_HUGEPAGE
+                    if (p)
+                        ::madvise(p, bytes, MADV_HUGEPAGE); // fails harmlessly when THP is off
+#endif
+                }
+            }
+            if (!p) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            ::munmap(p, mapping_bytes(n));
+        }
+
+        template<typename U>
+        bool operator==(const HugePageAllocator<U>&) const
+        {
+            return true;
+        }
+
+        template<typename U>
+        bool operator!=(const HugePageAllocator<U>&) const
+        {
+            return false;
+        }
+    };
+
+    namespace detail
+    {
+        // Mappings start on a page boundary.
+        template<typename T>
+        struct allocator_alignment<HugePageAllocator<T>> {
+            static constexpr std::size_t value = CACHE_LINE_BYTES;
+        };
+    } // namespace detail
+
+    typedef BitVector<HugePageAllocator<BitType>> HugePageBitVector;
+
+    // n bits of `value` on huge pages.  The fill runs on `pool` in chunks of
+    // one huge page, so each page is first touched by one worker and lands
+    // on that worker's NUMA node; a plain BitVector(n, value) memsets from
+    // the calling thread and puts every page on its node.
+    inline HugePageBitVector make_hugepage_bitvector(size_t n, bool value = false,
+                                                     HugePageMode mode = HugePageMode::Transparent,
+                                                     ThreadPool& pool = default_thread_pool())
+    {
+        HugePageBitVector bits(n, HugePageAllocator<BitType>(mode), adopt_storage);
+        const ParallelPolicy first_touch(pool, HugePageAllocator<BitType>::HUGE_PAGE_BYTES / sizeof(BitType));
+        bits.assign(first_touch, n, value);
+        return bits;
+    }
+
+} // namespace bowen
+
+#endif
@@ -0,0 +1,401 @@
+#ifndef BITVECTOR_MAPPED_BITVECTOR_H
+#define BITVECTOR_MAPPED_BITVECTOR_H
+
+#include "bitvector.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bowen
+{
+    // ReadOnly maps the file copy-on-write: the vector can still be
+    // modified, but the changes stay in private pages and never reach the
+    // file.
+    enum class MapMode { ReadOnly, ReadWrite };
+
+    // Access pattern hints passed to madvise.
+    enum class MapAccess { Normal, Sequential, Random, WillNeed };
+
+    // A bit vector file mapped into memory.  The file is a 64-byte header
+    // followed by the words:
+    //
+    //   bytes 0-7    magic "BOWENBV1"
+    //   bytes 8-15   number of bits (native endian)
+    //   bytes 16-63  reserved, zero
+    //
+    // so the words start on a cache line and the vector kernels may use
+    // aligned loads on them.  Opening maps the whole file and reads nothing;
+    // pages are faulted in by the first access.  Growing extends the file
+    // with ftruncate and the mapping with mremap, which keeps the pages
+    // already mapped in place of copying them.
+    //
+    // Every failing system call throws std::system_error.
+    class MappedFile
+    {
+    public:
+        static constexpr size_t HEADER_BYTES = 64;
+
+    private:
+        static constexpr char MAGIC[8] = {'B', 'O', 'W', 'E', 'N', 'B', 'V', '1'};
+
+        std::string m_path;
+        int m_fd;
+        MapMode m_mode;
+        unsigned char* m_base;
+        size_t m_length; // bytes of file and mapping
+        bool m_claimed;  // the words belong to a vector
+
+        [[noreturn]] static void fail(const char* what, const std::string& path)
+        {
+            throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path);
+        }
+
+        void map(const std::string& path)
+        {
+            const int share = m_mode == MapMode::ReadOnly ? MAP_PRIVATE : MAP_SHARED;
+            void* p = ::mmap(nullptr, m_length, PROT_READ | PROT_WRITE, share, m_fd, 0);
+            if (p == MAP_FAILED) {
+                const int err = errno;
+                ::close(m_fd);
+                errno = err;
+                fail("mmap", path);
+            }
+            m_base = static_cast<unsigned char*>(p);
+        }
+
+    public:
+        // Opens an existing bit vector file, or with `create` replaces the
+        // file at `path` by an empty one (create requires ReadWrite).
+        MappedFile(const std::string& path, MapMode mode, bool create = false)
+            : m_path(path), m_fd(-1), m_mode(mode), m_base(nullptr), m_length(0), m_claimed(false)
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (create && mode == MapMode::ReadOnly){
+                std::stringstream  ss;
+                ss << "MappedFile cannot create a read-only file" << " path: " << path << std::endl;
+                throw std::invalid_argument(ss.str());
+            }
+#endif
+            const int flags = mode == MapMode::ReadOnly ? O_RDONLY : O_RDWR;
+            m_fd = ::open(path.c_str(), create ? flags | O_CREAT | O_TRUNC : flags, 0644);
+            if (m_fd < 0)
+                fail("open", path);
+            if (create) {
+                if (::ftruncate(m_fd, HEADER_BYTES) != 0) {
+                    const int err = errno;
+                    ::close(m_fd);
+                    errno = err;
+                    fail("ftruncate", path);
+                }
+                m_length = HEADER_BYTES;
+                map(path);
+                std::memcpy(m_base, MAGIC, sizeof(MAGIC));
+                return;
+            }
+            struct stat st;
+            if (::fstat(m_fd, &st) != 0) {
+                const int err = errno;
+                ::close(m_fd);
+                errno = err;
+                fail("fstat", path);
+            }
+            m_length = static_cast<size_t>(st.st_size);
+            if (m_length < HEADER_BYTES) {
+                ::close(m_fd);
+                throw std::runtime_error("MappedFile: not a bit vector file: " + path);
+            }
+            map(path);
+            const uint64_t bits = bit_count();
+            if (std::memcmp(m_base, MAGIC, sizeof(MAGIC)) != 0 ||
+                bits > static_cast<uint64_t>(capacity_words()) * WORD_BITS) {
+                ::munmap(m_base, m_length);
+                ::close(m_fd);
+                throw std::runtime_error("MappedFile: not a bit vector file: " + path);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile()
+        {
+            ::munmap(m_base, m_length);
+            ::close(m_fd);
+        }
+
+        MapMode mode() const
+        {
+            return m_mode;
+        }
+
+        BitType* words() const
+        {
+            return reinterpret_cast<BitType*>(m_base + HEADER_BYTES);
+        }
+
+        // Words the file currently holds.
+        size_t capacity_words() const
+        {
+            return (m_length - HEADER_BYTES) / sizeof(BitType);
+        }
+
+        uint64_t bit_count() const
+        {
+            uint64_t bits;
+            std::memcpy(&bits, m_base + sizeof(MAGIC), sizeof(bits));
+            return bits;
+        }
+
+        void set_bit_count(uint64_t bits)
+        {
+            std::memcpy(m_base + sizeof(MAGIC), &bits, sizeof(bits));
+        }
+
+        // A file holds the words of one vector.  claim() marks them as taken
+        // and throws std::runtime_error if they already are; unclaim() gives
+        // them back.
+        void claim()
+        {
+            if (m_claimed)
+                throw std::runtime_error("MappedFile: words already belong to another vector: " + m_path);
+            m_claimed = true;
+        }
+
+        void unclaim() noexcept
+        {
+            m_claimed = false;
+        }
+
+        // Grows the file to at least `words` words.  The mapping may move;
+        // the words keep their contents and new words read as zero.
+        void reserve_words(size_t words)
+        {
+            if (words <= capacity_words())
+                return;
+            if (m_mode == MapMode::ReadOnly)
+                throw std::runtime_error("MappedFile: cannot grow a read-only mapping: " + m_path);
+            const size_t length = HEADER_BYTES + words * sizeof(BitType);
+            if (::ftruncate(m_fd, static_cast<off_t>(length)) != 0)
+                fail("ftruncate", m_path);
+#ifdef __linux__
+            void* p = ::mremap(m_base, m_length, length, MREMAP_MAYMOVE);
+            if (p == MAP_FAILED)
+                fail("mremap", m_path);
+#else
+            void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            if (p == MAP_FAILED)
+                fail("mmap", m_path);
+            ::munmap(m_base, m_length);
+#endif
+            m_base = static_cast<unsigned char*>(p);
+            m_length = length;
+        }
+
+        // Writes dirty pages back to the file; with `async` only schedules
+        // the write-back.
+        void sync(bool async = false)
+        {
+            if (::msync(m_base, m_length, async ? MS_ASYNC : MS_SYNC) != 0)
+                fail("msync", m_path);
+        }
+
+        void advise(MapAccess access)
+        {
+            int advice = MADV_NORMAL;
+            switch (access) {
+                case MapAccess::Normal: advice = MADV_NORMAL; break;
+                case MapAccess::Sequential: advice = MADV_SEQUENTIAL; break;
+                case MapAccess::Random: advice = MADV_RANDOM; break;
+                case MapAccess::WillNeed: advice = MADV_WILLNEED; break;
+            }
+            if (::madvise(m_base, m_length, advice) != 0)
+                fail("madvise", m_path);
+        }
+    };
+
+    // Allocator for BitVectors that live in a MappedFile.  allocate() grows
+    // the file and returns its words, deallocate() leaves them in the file,
+    // and reallocate() lets reserve() grow the vector through mremap instead
+    // of copying.  The file has room for one vector: allocating from it
+    // again before the words are deallocated throws std::runtime_error.
+    // A default-constructed MappedAllocator has no file and hands out
+    // anonymous mappings, which is what copies of a mapped vector get.
+    template<typename T>
+    class MappedAllocator
+    {
+    private:
+        std::shared_ptr<MappedFile> m_file;
+
+        template<typename U>
+        friend class MappedAllocator;
+
+        static size_t bytes(std::size_t n)
+        {
+            return n ? n * sizeof(T) : 1;
+        }
+
+        static size_t file_words(std::size_t n)
+        {
+            return (n * sizeof(T) + sizeof(BitType) - 1) / sizeof(BitType);
+        }
+
+    public:
+        typedef T value_type;
+
+        MappedAllocator() noexcept {}
+
+        explicit MappedAllocator(std::shared_ptr<MappedFile> file) noexcept
+            : m_file(std::move(file)) {}
+
+        template<typename U>
+        MappedAllocator(const MappedAllocator<U>& other) noexcept
+            : m_file(other.m_file) {}
+
+        const std::shared_ptr<MappedFile>& file() const
+        {
+            return m_file;
+        }
+
+        // Copies of a mapped vector live in anonymous memory, not the file.
+        MappedAllocator select_on_container_copy_construction() const
+        {
+            return MappedAllocator();
+        }
+
+        T* allocate(std::size_t n)
+        {
+            if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+                throw std::bad_alloc();
+            }
+            if (m_file) {
+                m_file->claim();
+                try {
+                    m_file->reserve_words(file_words(n));
+                } catch (...) {
+                    m_file->unclaim();
+                    throw;
+                }
+                return reinterpret_cast<T*>(m_file->words());
+            }
+            void* p = ::mmap(nullptr, bytes(n), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            if (m_file)
+                m_file->unclaim();
+            else
+                ::munmap(p, bytes(n));
+        }
+
+        T* reallocate(T* p, std::size_t old_n, std::size_t new_n)
+        {
+            if (!p)
+                return allocate(new_n);
+            if (m_file) {
+                m_file->reserve_words(file_words(new_n));
+                return reinterpret_cast<T*>(m_file->words());
+            }
+#ifdef __linux__
+            void* q = ::mremap(p, bytes(old_n), bytes(new_n), MREMAP_MAYMOVE);
+            if (q == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(q);
+#else
+            T* q = allocate(new_n);
+            std::memcpy(q, p, std::min(old_n, new_n) * sizeof(T));
+            deallocate(p, old_n);
+            return q;
+#endif
+        }
+
+        template<typename U>
+        bool operator==(const MappedAllocator<U>& other) const
+        {
+            return m_file == other.m_file;
+        }
+
+        template<typename U>
+        bool operator!=(const MappedAllocator<U>& other) const
+        {
+            return m_file != other.m_file;
+        }
+    };
+
+    namespace detail
+    {
+        // File words start HEADER_BYTES into a page-aligned mapping and
+        // anonymous mappings are page-aligned.
+        template<typename T>
+        struct allocator_alignment<MappedAllocator<T>> {
+            static constexpr std::size_t value = MappedFile::HEADER_BYTES;
+        };
+    } // namespace detail
+
+    // BitVector whose words live in a memory-mapped file.  Every BitVector
+    // operation works on it unchanged.
+    //
+    //     auto bits = bowen::create_mapped_bitvector("bits.bv", 1000000000);
+    //     bits.set_bit(42, true);
+    //     bowen::sync(bits);                 // header and pages to disk
+    //
+    //     const auto view = bowen::open_mapped_bitvector("bits.bv", bowen::MapMode::ReadOnly);
+    //     size_t ones = view.count();        // no read() of the file
+    //
+    // The size stored in the file is only updated by sync().  Copies of a
+    // mapped vector are ordinary in-memory vectors, while assigning to a
+    // mapped vector writes into its file.  Writes to a vector opened
+    // ReadOnly are copy-on-write and stay in memory; growing it throws.
+    typedef BitVector<MappedAllocator<BitType>> MappedBitVector;
+
+    // Creates (or truncates) the file at `path` holding n bits of `value`.
+    inline MappedBitVector create_mapped_bitvector(const std::string& path, size_t n, bool value = false)
+    {
+        auto file = std::make_shared<MappedFile>(path, MapMode::ReadWrite, true);
+        file->set_bit_count(n);
+        return MappedBitVector(n, value, MappedAllocator<BitType>(std::move(file)));
+    }
+
+    // Maps the bit vector file at `path`; the bits are not read.
+    inline MappedBitVector open_mapped_bitvector(const std::string& path, MapMode mode = MapMode::ReadWrite)
+    {
+        auto file = std::make_shared<MappedFile>(path, mode);
+        const size_t n = static_cast<size_t>(file->bit_count());
+        return MappedBitVector(n, MappedAllocator<BitType>(std::move(file)), adopt_storage);
+    }
+
+    // Stores size() in the file header and writes the dirty pages back.
+    // Does nothing for vectors without a file.
+    inline void sync(const MappedBitVector& bits, bool async = false)
+    {
+        const std::shared_ptr<MappedFile> file = bits.get_allocator().file();
+        if (!file)
+            return;
+        if (file->mode() == MapMode::ReadWrite)
+            file->set_bit_count(bits.size());
+        file->sync(async);
+    }
+
+    inline void advise(const MappedBitVector& bits, MapAccess access)
+    {
+        const std::shared_ptr<MappedFile> file = bits.get_allocator().file();
+        if (file)
+            file->advise(access);
+    }
+
+} // namespace bowen
+
+#endif
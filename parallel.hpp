@@ -0,0 +1,292 @@
+#ifndef BITVECTOR_PARALLEL_H
+#define BITVECTOR_PARALLEL_H
+
+#include "bitvector.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bowen
+{
+    // Fixed-size, reusable work-stealing thread pool.
+    //
+    // run(tasks, fn) splits the task indices [0, tasks) into one contiguous
+    // range per participating thread (the calling thread is one of them).
+    // Each thread pops tasks from the front of its own range, so neighbouring
+    // chunks stay on the same core; a thread whose range is empty steals
+    // single tasks from the back of the others' ranges.  Both ends of a range
+    // live in one 64-bit word updated by compare-and-swap, so no locks are
+    // taken while tasks run.
+    //
+    // Workers sleep on a condition variable between runs.  run() blocks until
+    // every task has finished; tasks must not throw and must not call run()
+    // on the same pool.  Calls from different threads are serialized, so
+    // several threads may share one pool (default_thread_pool() is shared
+    // by every default ParallelPolicy).
+    class ThreadPool
+    {
+    private:
+        struct alignas(detail::CACHE_LINE_BYTES) Queue {
+            std::atomic<uint64_t> range; // front in the low half, back (exclusive) in the high half
+        };
+
+        static uint64_t pack(uint64_t front, uint64_t back)
+        {
+            return front | (back << 32);
+        }
+
+        unsigned m_threads;
+        std::vector<std::thread> m_workers;
+        std::unique_ptr<Queue[]> m_queues;
+
+        std::mutex m_run_mutex; // held by the caller for a whole multi-thread run
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        uint64_t m_generation = 0;
+        bool m_stop = false;
+        unsigned m_participants = 0;
+        unsigned m_active = 0;
+        void (*m_invoke)(void*, size_t) = nullptr;
+        void* m_context = nullptr;
+
+        bool pop_front(unsigned q, size_t& task)
+        {
+            uint64_t r = m_queues[q].range.load(std::memory_order_relaxed);
+            for (;;) {
+                const uint64_t front = r & 0xffffffffu;
+                const uint64_t back = r >> 32;
+                if (front >= back)
+                    return false;
+                if (m_queues[q].range.compare_exchange_weak(r, pack(front + 1, back), std::memory_order_relaxed)) {
+                    task = static_cast<size_t>(front);
+                    return true;
+                }
+            }
+        }
+
+        bool steal_back(unsigned q, size_t& task)
+        {
+            uint64_t r = m_queues[q].range.load(std::memory_order_relaxed);
+            for (;;) {
+                const uint64_t front = r & 0xffffffffu;
+                const uint64_t back = r >> 32;
+                if (front >= back)
+                    return false;
+                if (m_queues[q].range.compare_exchange_weak(r, pack(front, back - 1), std::memory_order_relaxed)) {
+                    task = static_cast<size_t>(back - 1);
+                    return true;
+                }
+            }
+        }
+
+        void work(unsigned self, unsigned participants)
+        {
+            size_t task;
+            for (;;) {
+                if (pop_front(self, task)) {
+                    m_invoke(m_context, task);
+                    continue;
+                }
+                bool stole = false;
+                for (unsigned k = 1; k < participants && !stole; ++k) {
+                    if (steal_back((self + k) % participants, task)) {
+                        m_invoke(m_context, task);
+                        stole = true;
+                    }
+                }
+                if (!stole)
+                    return;
+            }
+        }
+
+        void worker_loop(unsigned self)
+        {
+            uint64_t seen = 0;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;) {
+                m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop)
+                    return;
+                seen = m_generation;
+                const unsigned participants = m_participants;
+                if (self >= participants)
+                    continue;
+                lock.unlock();
+                work(self, participants);
+                lock.lock();
+                if (--m_active == 0)
+                    m_done.notify_one();
+            }
+        }
+
+    public:
+        // `threads` counts the calling thread, so ThreadPool(1) starts no
+        // workers and runs everything inline.  0 means one per hardware thread.
+        explicit ThreadPool(unsigned threads = 0)
+            : m_threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+              m_queues(new Queue[m_threads])
+        {
+            for (unsigned t = 0; t < m_threads; ++t)
+                m_queues[t].range.store(0, std::memory_order_relaxed);
+            for (unsigned t = 1; t < m_threads; ++t)
+                m_workers.emplace_back(&ThreadPool::worker_loop, this, t);
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& t : m_workers)
+                t.join();
+        }
+
+        // Number of threads that take part in run(), the caller included.
+        unsigned size() const
+        {
+            return m_threads;
+        }
+
+        // Calls fn(i) once for every i in [0, tasks) and returns when all
+        // calls have finished.
+        template<typename Fn>
+        void run(size_t tasks, Fn&& fn)
+        {
+            if (tasks == 0)
+                return;
+            const unsigned participants = static_cast<unsigned>(std::min<size_t>(m_threads, tasks));
+            if (participants <= 1) {
+                for (size_t i = 0; i < tasks; ++i)
+                    fn(i);
+                return;
+            }
+            std::lock_guard<std::mutex> run_lock(m_run_mutex);
+            for (unsigned p = 0; p < participants; ++p) {
+                const uint64_t front = static_cast<uint64_t>(tasks) * p / participants;
+                const uint64_t back = static_cast<uint64_t>(tasks) * (p + 1) / participants;
+                m_queues[p].range.store(pack(front, back), std::memory_order_relaxed);
+            }
+            using F = std::remove_reference_t<Fn>;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_invoke = [](void* context, size_t i) { (*static_cast<F*>(context))(i); };
+                m_context = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+                m_participants = participants;
+                m_active = participants - 1;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+            work(0, participants);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [&] { return m_active == 0; });
+        }
+    };
+
+    // Process-wide pool with one thread per hardware thread, created on first
+    // use.
+    inline ThreadPool& default_thread_pool()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Execution policy for the parallel BitVector overloads.  Word ranges are
+    // cut into chunks of `chunk_words` words (rounded up to whole cache
+    // lines) whose boundaries fall on cache-line addresses, and the chunks
+    // are run on `pool`.  Ranges of a single chunk run inline.
+    //
+    //     bowen::ThreadPool pool(8);
+    //     bowen::ParallelPolicy par(pool);
+    //     a.and_assign(par, b);
+    //     size_t ones = a.count(par);
+    class ParallelPolicy : public detail::execution_policy_tag
+    {
+    public:
+        // 256 KiB per chunk: large enough to amortise scheduling, small
+        // enough to balance 10^9-bit vectors across dozens of threads.
+        static constexpr size_t DEFAULT_CHUNK_WORDS = 32768;
+
+    private:
+        static constexpr size_t LINE_WORDS = detail::CACHE_LINE_BYTES / sizeof(BitType);
+
+        ThreadPool* m_pool;
+        size_t m_chunk_words;
+
+        // Words before the first cache-line boundary at or after base.
+        static size_t lead_words(const BitType* base)
+        {
+            const uintptr_t misalign = reinterpret_cast<uintptr_t>(base) & (detail::CACHE_LINE_BYTES - 1);
+            return ((detail::CACHE_LINE_BYTES - misalign) & (detail::CACHE_LINE_BYTES - 1)) / sizeof(BitType);
+        }
+
+    public:
+        explicit ParallelPolicy(ThreadPool& pool = default_thread_pool(), size_t chunk_words = DEFAULT_CHUNK_WORDS)
+            : m_pool(&pool),
+              m_chunk_words((std::max(chunk_words, LINE_WORDS) + LINE_WORDS - 1) / LINE_WORDS * LINE_WORDS) {}
+
+        ThreadPool& pool() const
+        {
+            return *m_pool;
+        }
+
+        size_t chunk_words() const
+        {
+            return m_chunk_words;
+        }
+
+        // Calls fn(begin, end) for consecutive word ranges covering
+        // [0, words).  Chunk i > 0 starts at lead + i * chunk_words(), where
+        // base + lead is the first cache-line boundary.
+        template<typename Fn>
+        void for_each(const BitType* base, size_t words, Fn fn) const
+        {
+            if (words <= m_chunk_words) {
+                if (words)
+                    fn(static_cast<size_t>(0), words);
+                return;
+            }
+            const size_t lead = lead_words(base);
+            const size_t chunk = m_chunk_words;
+            const size_t chunks = (words - lead + chunk - 1) / chunk;
+            m_pool->run(chunks, [&](size_t i) {
+                const size_t b = i ? lead + i * chunk : 0;
+                const size_t e = std::min(words, lead + (i + 1) * chunk);
+                fn(b, e);
+            });
+        }
+
+        // Folds fn(begin, end) over the chunks of [0, words) with combine,
+        // in chunk order.
+        template<typename T, typename Fn, typename Combine>
+        T reduce(const BitType* base, size_t words, T init, Fn fn, Combine combine) const
+        {
+            if (words <= m_chunk_words)
+                return words ? combine(init, fn(static_cast<size_t>(0), words)) : init;
+            const size_t lead = lead_words(base);
+            const size_t chunk = m_chunk_words;
+            const size_t chunks = (words - lead + chunk - 1) / chunk;
+            std::vector<T> partial(chunks, init);
+            m_pool->run(chunks, [&](size_t i) {
+                const size_t b = i ? lead + i * chunk : 0;
+                const size_t e = std::min(words, lead + (i + 1) * chunk);
+                partial[i] = fn(b, e);
+            });
+            for (const T& p : partial)
+                init = combine(init, p);
+            return init;
+        }
+    };
+
+} // namespace bowen
+
+#endif
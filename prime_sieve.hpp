@@ -0,0 +1,236 @@
+#ifndef BITVECTOR_PRIME_SIEVE_H
+#define BITVECTOR_PRIME_SIEVE_H
+
+#include "bitvector.hpp"
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace bowen
+{
+    // Segmented, odd-only Sieve of Eratosthenes on BitVector segments.
+    //
+    // Bit j of the sieve stands for the odd number 2j + 1.  The range is cut
+    // into segments of `segment_bits` bits (256 KiB by default, sized to sit
+    // in L2); each segment starts all ones and every base prime p clears its
+    // odd multiples with set_stride(first, p, count, false), which for small
+    // p ORs a precomputed word pattern instead of touching bits one by one.
+    // Only the base primes up to sqrt(limit) are kept in memory, so limits
+    // far beyond what a flat vector could hold (10^11 and up) work.
+    class PrimeSieve
+    {
+    public:
+        static constexpr size_t DEFAULT_SEGMENT_BITS = static_cast<size_t>(1) << 21;
+
+    private:
+        uint64_t m_limit;
+        size_t m_segment_bits;
+        uint64_t m_odd_count; // odd numbers below the limit
+        std::vector<uint32_t> m_base_primes; // odd primes up to sqrt(limit)
+
+        static uint64_t isqrt(uint64_t n)
+        {
+            uint64_t r = 0;
+            for (uint64_t bit = static_cast<uint64_t>(1) << 31; bit; bit >>= 1) {
+                const uint64_t t = r | bit;
+                if (t * t <= n)
+                    r = t;
+            }
+            return r;
+        }
+
+    public:
+        // Sieves the primes below `limit`.
+        explicit PrimeSieve(uint64_t limit, size_t segment_bits = DEFAULT_SEGMENT_BITS)
+            : m_limit(limit), m_segment_bits(segment_bits), m_odd_count(limit / 2)
+        {
+            const uint64_t root = isqrt(limit);
+            // Plain odd-only sieve for the base primes.
+            BitVector<> small(static_cast<size_t>(root / 2 + 1), true);
+            for (uint64_t j = 1; j < small.size(); ++j) {
+                if (!small[j])
+                    continue;
+                const uint64_t p = 2 * j + 1;
+                m_base_primes.push_back(static_cast<uint32_t>(p));
+                const uint64_t first = (p * p) / 2;
+                if (first < small.size())
+                    small.set_stride(first, p, (small.size() - 1 - first) / p + 1, false);
+            }
+        }
+
+        uint64_t limit() const
+        {
+            return m_limit;
+        }
+
+        size_t segment_bits() const
+        {
+            return m_segment_bits;
+        }
+
+        size_t segment_count() const
+        {
+            return static_cast<size_t>((m_odd_count + m_segment_bits - 1) / m_segment_bits);
+        }
+
+        // Fills `seg` with segment s: bit j is set iff the odd number
+        // 2 * (s * segment_bits() + j) + 1 is prime.  Returns the index of
+        // the segment's first odd number.
+        uint64_t sieve_segment(size_t s, BitVector<>& seg) const
+        {
+            const uint64_t first_index = static_cast<uint64_t>(s) * m_segment_bits;
+            const size_t bits = static_cast<size_t>(std::min<uint64_t>(m_segment_bits, m_odd_count - first_index));
+            const uint64_t lo = 2 * first_index + 1;
+            const uint64_t hi = lo + 2 * bits; // exclusive
+            seg.assign(bits, true);
+            for (uint32_t p : m_base_primes) {
+                const uint64_t pp = static_cast<uint64_t>(p) * p;
+                if (pp >= hi)
+                    break;
+                uint64_t m = std::max<uint64_t>(pp, (lo + p - 1) / p * p);
+                if ((m & 1) == 0)
+                    m += p;
+                if (m >= hi)
+                    continue;
+                const size_t idx = static_cast<size_t>((m - lo) / 2);
+                seg.set_stride(idx, p, (bits - 1 - idx) / p + 1, false);
+            }
+            if (s == 0 && bits)
+                seg.set_bit(0, false); // 1 is not prime
+            return first_index;
+        }
+
+        // Number of primes below limit().  With threads > 1 the segments are
+        // handed out to worker threads through a shared counter; each worker
+        // owns its segment buffer.
+        uint64_t count(unsigned threads = 1) const
+        {
+            if (m_limit <= 2)
+                return 0;
+            const size_t segments = segment_count();
+            std::atomic<size_t> next(0);
+            std::atomic<uint64_t> total(1); // the prime 2
+            auto worker = [&]() {
+                BitVector<> seg;
+                uint64_t local = 0;
+                for (size_t s; (s = next.fetch_add(1, std::memory_order_relaxed)) < segments;) {
+                    sieve_segment(s, seg);
+                    local += seg.count();
+                }
+                total.fetch_add(local, std::memory_order_relaxed);
+            };
+            if (threads <= 1) {
+                worker();
+            } else {
+                std::vector<std::thread> pool;
+                for (unsigned t = 0; t < threads; ++t)
+                    pool.emplace_back(worker);
+                for (auto& t : pool)
+                    t.join();
+            }
+            return total.load();
+        }
+    };
+
+    // Forward iterator over the primes below a limit, in increasing order.
+    // Segments are sieved lazily as the iterator reaches them and their
+    // primes are pulled out in bulk with extract_ones.  A default-constructed
+    // iterator is the end sentinel.
+    class PrimeIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = const uint64_t&;
+
+    private:
+        const PrimeSieve* m_sieve;
+        size_t m_segment;
+        BitVector<> m_bits;
+        std::vector<uint64_t> m_primes;
+        size_t m_pos;
+
+        // Loads the next segment that contains at least one prime, or turns
+        // the iterator into the end sentinel.
+        void load_next_segment()
+        {
+            m_primes.clear();
+            m_pos = 0;
+            while (m_primes.empty() && m_segment < m_sieve->segment_count()) {
+                const uint64_t base = m_sieve->sieve_segment(m_segment++, m_bits);
+                m_primes.resize(m_bits.count());
+                m_bits.extract_ones(m_primes.data(), base);
+                for (auto& index : m_primes)
+                    index = 2 * index + 1;
+            }
+            if (m_primes.empty())
+                m_sieve = nullptr;
+        }
+
+    public:
+        PrimeIterator()
+            : m_sieve(nullptr), m_segment(0), m_pos(0) {}
+
+        explicit PrimeIterator(const PrimeSieve& sieve)
+            : m_sieve(&sieve), m_segment(0), m_pos(0)
+        {
+            if (sieve.limit() > 2)
+                m_primes.push_back(2);
+            else
+                m_sieve = nullptr;
+        }
+
+        reference operator*() const
+        {
+            return m_primes[m_pos];
+        }
+
+        pointer operator->() const
+        {
+            return &m_primes[m_pos];
+        }
+
+        PrimeIterator& operator++()
+        {
+            if (++m_pos == m_primes.size())
+                load_next_segment();
+            return *this;
+        }
+
+        PrimeIterator operator++(int)
+        {
+            PrimeIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const PrimeIterator& other) const
+        {
+            if (!m_sieve || !other.m_sieve)
+                return m_sieve == other.m_sieve;
+            return m_segment == other.m_segment && m_pos == other.m_pos;
+        }
+
+        bool operator!=(const PrimeIterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    inline PrimeIterator begin(const PrimeSieve& sieve)
+    {
+        return PrimeIterator(sieve);
+    }
+
+    inline PrimeIterator end(const PrimeSieve&)
+    {
+        return PrimeIterator();
+    }
+
+} // namespace bowen
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef BITVECTOR_RANK_SELECT_H
+#define BITVECTOR_RANK_SELECT_H
+
+#include "bitvector.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace bowen
+{
+    // Static rank/select index over a BitVector, using the poppy layout
+    // (Zhou, Andersen, Kaminsky 2013):
+    //
+    //  - L0: absolute count of ones before every 2^32-bit superblock.
+    //  - One 64-bit entry per 2048-bit basic block, holding the count of ones
+    //    before the block relative to its superblock (low 32 bits) and the
+    //    popcounts of its first three 512-bit sub-blocks (3 x 10 bits).
+    //  - Every SELECT_SAMPLE-th one (and zero) records the basic block that
+    //    holds it, so select starts its scan close to the answer.
+    //
+    // The entries add 3.125% on top of the bits, the select samples about
+    // another 0.8%.  rank1 touches one entry and at most one 512-bit
+    // sub-block (a single cache line when the bits are 64-byte aligned).
+    //
+    // The index borrows the vector's storage; the vector must outlive it and
+    // must not be modified while the index is in use.
+    class RankSelect
+    {
+    public:
+        static constexpr size_t BLOCK_BITS = 2048;
+        static constexpr size_t SUB_BITS = 512;
+        static constexpr size_t SELECT_SAMPLE = 8192;
+
+    private:
+        static constexpr int BLOCK_SHIFT = 11;
+        static constexpr int SUB_SHIFT = 9;
+        static constexpr int L0_SHIFT = 32;
+        static constexpr size_t BLOCK_WORDS = BLOCK_BITS / WORD_BITS;
+        static constexpr size_t SUB_WORDS = SUB_BITS / WORD_BITS;
+
+        const BitType* m_bits;
+        size_t m_size;
+        size_t m_ones;
+        std::vector<uint64_t> m_l0;
+        std::vector<uint64_t> m_entries;
+        std::vector<uint64_t> m_select1_samples;
+        std::vector<uint64_t> m_select0_samples;
+
+        static unsigned int l2(uint64_t entry, size_t sub)
+        {
+            return static_cast<unsigned int>((entry >> (32 + 10 * sub)) & 1023);
+        }
+
+        // Number of ones before basic block b.
+        size_t block_rank(size_t b) const
+        {
+            return m_l0[(b << BLOCK_SHIFT) >> L0_SHIFT] + static_cast<uint32_t>(m_entries[b]);
+        }
+
+        // Word w with the bits past size() cleared.
+        BitType word_at(size_t w) const
+        {
+            BitType word = m_bits[w];
+            if (w == (m_size >> WORD_SHIFT))
+                word &= detail::tail_mask(m_size);
+            return word;
+        }
+
+        void build()
+        {
+            const size_t words = (m_size + WORD_BITS - 1) / WORD_BITS;
+            const size_t blocks = (m_size >> BLOCK_SHIFT) + 1;
+            m_l0.clear();
+            m_entries.assign(blocks, 0);
+            m_select1_samples.clear();
+            m_select0_samples.clear();
+
+            size_t ones = 0;
+            size_t next_one_sample = 0;
+            size_t next_zero_sample = 0;
+            for (size_t b = 0; b < blocks; ++b) {
+                const size_t first_bit = b << BLOCK_SHIFT;
+                if ((first_bit & ((static_cast<size_t>(1) << L0_SHIFT) - 1)) == 0)
+                    m_l0.push_back(ones);
+                uint64_t entry = ones - m_l0.back();
+                size_t block_ones = 0;
+                for (size_t sub = 0; sub < BLOCK_WORDS / SUB_WORDS; ++sub) {
+                    size_t sub_ones = 0;
+                    const size_t w0 = b * BLOCK_WORDS + sub * SUB_WORDS;
+                    for (size_t w = w0; w < w0 + SUB_WORDS && w < words; ++w)
+                        sub_ones += detail::popcount_word(word_at(w));
+                    if (sub < 3)
+                        entry |= static_cast<uint64_t>(sub_ones) << (32 + 10 * sub);
+                    block_ones += sub_ones;
+                }
+                m_entries[b] = entry;
+
+                const size_t block_bits = first_bit < m_size ? std::min(BLOCK_BITS, m_size - first_bit) : 0;
+                const size_t zeros_before = first_bit - ones;
+                for (; next_one_sample < ones + block_ones; next_one_sample += SELECT_SAMPLE)
+                    m_select1_samples.push_back(b);
+                for (; next_zero_sample < zeros_before + block_bits - block_ones; next_zero_sample += SELECT_SAMPLE)
+                    m_select0_samples.push_back(b);
+                ones += block_ones;
+            }
+            m_ones = ones;
+        }
+
+        void check_select(size_t k, size_t available) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (k >= available){
+                std::stringstream  ss;
+                ss << "RankSelect select out of range" << " k: " << k << " available: " << available << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#else
+            (void)k;
+            (void)available;
+#endif
+        }
+
+    public:
+        RankSelect()
+            : m_bits(nullptr), m_size(0), m_ones(0) {}
+
+        template<typename Allocator, std::size_t InlineBits>
+        explicit RankSelect(const BitVector<Allocator, InlineBits>& bits)
+            : m_bits(bits.data()), m_size(bits.size()), m_ones(0)
+        {
+            build();
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        size_t ones() const
+        {
+            return m_ones;
+        }
+
+        size_t zeros() const
+        {
+            return m_size - m_ones;
+        }
+
+        // Bytes used by the index itself, excluding the bits.
+        size_t index_bytes() const
+        {
+            return (m_l0.size() + m_entries.size() + m_select1_samples.size() +
+                    m_select0_samples.size()) * sizeof(uint64_t);
+        }
+
+        // Number of ones in [0, i).
+        size_t rank1(size_t i) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (i > m_size){
+                std::stringstream  ss;
+                ss << "RankSelect rank out of range" << " i: " << i << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            const size_t b = i >> BLOCK_SHIFT;
+            const uint64_t entry = m_entries[b];
+            size_t r = m_l0[i >> L0_SHIFT] + static_cast<uint32_t>(entry);
+            const size_t sub = (i >> SUB_SHIFT) & 3;
+            for (size_t s = 0; s < sub; ++s)
+                r += l2(entry, s);
+            const size_t wi = i >> WORD_SHIFT;
+            for (size_t w = (i >> SUB_SHIFT) * SUB_WORDS; w < wi; ++w)
+                r += detail::popcount_word(m_bits[w]);
+            if (i & (WORD_BITS - 1))
+                r += detail::popcount_word(m_bits[wi] & ((static_cast<BitType>(1) << (i & (WORD_BITS - 1))) - 1));
+            return r;
+        }
+
+        // Number of zeros in [0, i).
+        size_t rank0(size_t i) const
+        {
+            return i - rank1(i);
+        }
+
+        // Position of the k-th (0-based) one.
+        size_t select1(size_t k) const
+        {
+            check_select(k, m_ones);
+            size_t b = m_select1_samples[k / SELECT_SAMPLE];
+            while (b + 1 < m_entries.size() && block_rank(b + 1) <= k)
+                ++b;
+            size_t rem = k - block_rank(b);
+            const uint64_t entry = m_entries[b];
+            size_t sub = 0;
+            for (; sub < 3 && rem >= l2(entry, sub); ++sub)
+                rem -= l2(entry, sub);
+            size_t w = b * BLOCK_WORDS + sub * SUB_WORDS;
+            for (size_t pc; rem >= (pc = detail::popcount_word(m_bits[w])); ++w)
+                rem -= pc;
+            return (w << WORD_SHIFT) + detail::select_in_word(m_bits[w], static_cast<unsigned int>(rem));
+        }
+
+        // Position of the k-th (0-based) zero.
+        size_t select0(size_t k) const
+        {
+            check_select(k, zeros());
+            size_t b = m_select0_samples[k / SELECT_SAMPLE];
+            while (b + 1 < m_entries.size() && ((b + 1) << BLOCK_SHIFT) - block_rank(b + 1) <= k)
+                ++b;
+            size_t rem = k - ((b << BLOCK_SHIFT) - block_rank(b));
+            const uint64_t entry = m_entries[b];
+            size_t sub = 0;
+            for (; sub < 3 && rem >= SUB_BITS - l2(entry, sub); ++sub)
+                rem -= SUB_BITS - l2(entry, sub);
+            size_t w = b * BLOCK_WORDS + sub * SUB_WORDS;
+            for (size_t zc; rem >= (zc = WORD_BITS - detail::popcount_word(m_bits[w])); ++w)
+                rem -= zc;
+            return (w << WORD_SHIFT) + detail::select_in_word(~m_bits[w], static_cast<unsigned int>(rem));
+        }
+    };
+
+} // namespace bowen
+
+#endif
@@ -0,0 +1,748 @@
+#ifndef BITVECTOR_ROARING_H
+#define BITVECTOR_ROARING_H
+
+#include "bitvector.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace bowen
+{
+    namespace detail
+    {
+        // pshufb masks that move the 16-bit lanes selected by an 8-bit mask to
+        // the front of a vector, in order.
+        struct shuffle16_table {
+            alignas(16) uint8_t masks[256][16];
+
+            shuffle16_table()
+            {
+                for (unsigned m = 0; m < 256; ++m) {
+                    unsigned k = 0;
+                    for (unsigned lane = 0; lane < 8; ++lane) {
+                        if (m & (1u << lane)) {
+                            masks[m][k++] = static_cast<uint8_t>(2 * lane);
+                            masks[m][k++] = static_cast<uint8_t>(2 * lane + 1);
+                        }
+                    }
+                    for (; k < 16; ++k)
+                        masks[m][k] = 0xff;
+                }
+            }
+        };
+
+        inline const shuffle16_table& shuffle16()
+        {
+            static const shuffle16_table table;
+            return table;
+        }
+
+        // Intersection of two sorted, duplicate-free uint16 arrays.  `out` must
+        // have room for min(na, nb) + 8 values: the vector loop stores whole
+        // 8-lane blocks.  The SSE4.2 path compares 8 values of a against 8 of b
+        // per pcmpestrm (Schlegel, Willhalm, Lehner 2011) and compacts the
+        // matches with one pshufb.
+        inline size_t intersect_arrays16(const uint16_t* a, size_t na, const uint16_t* b, size_t nb, uint16_t* out)
+        {
+            size_t ia = 0, ib = 0, count = 0;
+#if defined(__SSE4_2__)
+            const size_t sa = na & ~static_cast<size_t>(7);
+            const size_t sb = nb & ~static_cast<size_t>(7);
+            if (sa && sb) {
+                const shuffle16_table& table = shuffle16();
+                __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+                __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+                for (;;) {
+                    const __m128i hits = _mm_cmpestrm(vb, 8, va, 8, _SIDD_UWORD_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+                    const unsigned m = static_cast<unsigned>(_mm_cvtsi128_si32(hits)) & 0xff;
+                    const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(table.masks[m]));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + count), _mm_shuffle_epi8(va, shuffle));
+                    count += static_cast<size_t>(_mm_popcnt_u32(m));
+                    const uint16_t amax = a[ia + 7];
+                    const uint16_t bmax = b[ib + 7];
+                    if (amax <= bmax) {
+                        ia += 8;
+                        if (ia == sa)
+                            break;
+                        va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + ia));
+                    }
+                    if (bmax <= amax) {
+                        ib += 8;
+                        if (ib == sb)
+                            break;
+                        vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + ib));
+                    }
+                }
+            }
+#endif
+            while (ia < na && ib < nb) {
+                if (a[ia] < b[ib]) {
+                    ++ia;
+                } else if (b[ib] < a[ia]) {
+                    ++ib;
+                } else {
+                    out[count++] = a[ia];
+                    ++ia;
+                    ++ib;
+                }
+            }
+            return count;
+        }
+
+        // Merge of two sorted, duplicate-free uint16 arrays; `out` needs room
+        // for na + nb values.
+        inline size_t union_arrays16(const uint16_t* a, size_t na, const uint16_t* b, size_t nb, uint16_t* out)
+        {
+            size_t ia = 0, ib = 0, count = 0;
+            while (ia < na && ib < nb) {
+                const uint16_t x = a[ia], y = b[ib];
+                out[count++] = x < y ? x : y;
+                ia += x <= y;
+                ib += y <= x;
+            }
+            while (ia < na)
+                out[count++] = a[ia++];
+            while (ib < nb)
+                out[count++] = b[ib++];
+            return count;
+        }
+    } // namespace detail
+
+    // Compressed bitmap over 32-bit positions in the style of Roaring
+    // (Lemire et al. 2016).  The position space is cut into 2^16-bit chunks
+    // keyed by the high 16 bits; every non-empty chunk is stored in the
+    // smallest of three containers:
+    //
+    //  - array:  sorted uint16 offsets, for at most ARRAY_MAX set bits;
+    //  - bitmap: a 2^16-bit BitVector on 64-byte aligned MMAllocator storage,
+    //            so the BitVector SIMD kernels run on it unchanged;
+    //  - run:    (start, length - 1) pairs, for long stretches of ones.
+    //
+    // AND and OR dispatch on the container pair.  array & array uses the
+    // SSE4.2 string-compare intersection, bitmap & bitmap and bitmap | bitmap
+    // the AVX2/AVX-512 word kernels with a fused popcount, and run containers
+    // are combined interval-wise or through a bitmap.  Results are converted
+    // back to the cheapest container.
+    class RoaringBitmap
+    {
+    public:
+        static constexpr size_t CHUNK_BITS = static_cast<size_t>(1) << 16;
+        // Above this many values an array container is larger than a bitmap.
+        static constexpr size_t ARRAY_MAX = 4096;
+
+    private:
+        static constexpr size_t CHUNK_WORDS = CHUNK_BITS / WORD_BITS;
+        typedef BitVector<MMAllocator<BitType, 64>> ChunkBits;
+
+        enum class Kind : uint8_t { Array, Bitmap, Run };
+
+        struct Container {
+            Kind kind = Kind::Array;
+            uint32_t cardinality = 0;
+            std::vector<uint16_t> values; // Array: sorted offsets.  Run: start, length - 1 pairs.
+            ChunkBits bits;               // Bitmap: all CHUNK_BITS bits.
+        };
+
+        std::vector<uint16_t> m_keys;
+        std::vector<Container> m_containers;
+
+        static size_t popcount_chunk(const BitType* words)
+        {
+            return detail::popcount_kernel(detail::word_source<64>{words}, CHUNK_WORDS);
+        }
+
+        static void set_in_chunk(BitType* words, uint16_t v)
+        {
+            words[v >> WORD_SHIFT] |= static_cast<BitType>(1) << (v & (WORD_BITS - 1));
+        }
+
+        static bool test_in_chunk(const BitType* words, uint16_t v)
+        {
+            return (words[v >> WORD_SHIFT] >> (v & (WORD_BITS - 1))) & 1;
+        }
+
+        // Writes base + the position of every set bit of w to out, in
+        // order, and returns how many there are.  Four positions are always
+        // stored, so out needs room for four entries past the count; in
+        // exchange sparse words cost no unpredictable branches.
+        static size_t flatten_word(BitType w, size_t base, uint16_t* out)
+        {
+            const size_t count = detail::popcount_word(w);
+            out[0] = static_cast<uint16_t>(base + _tzcnt_u64(w));
+            w = _blsr_u64(w);
+            out[1] = static_cast<uint16_t>(base + _tzcnt_u64(w));
+            w = _blsr_u64(w);
+            out[2] = static_cast<uint16_t>(base + _tzcnt_u64(w));
+            w = _blsr_u64(w);
+            out[3] = static_cast<uint16_t>(base + _tzcnt_u64(w));
+            w = _blsr_u64(w);
+            for (size_t i = 4; w; ++i) {
+                out[i] = static_cast<uint16_t>(base + _tzcnt_u64(w));
+                w = _blsr_u64(w);
+            }
+            return count;
+        }
+
+        static size_t run_count(const Container& c)
+        {
+            if (c.kind == Kind::Run)
+                return c.values.size() / 2;
+            size_t runs = 0;
+            if (c.kind == Kind::Array) {
+                for (size_t i = 0; i < c.values.size(); ++i)
+                    runs += i == 0 || c.values[i] != c.values[i - 1] + 1;
+                return runs;
+            }
+            // A run starts at every set bit whose lower neighbour is clear.
+            const BitType* w = c.bits.data();
+            BitType carry = 0;
+            for (size_t i = 0; i < CHUNK_WORDS; ++i) {
+                runs += detail::popcount_word(w[i] & ~((w[i] << 1) | carry));
+                carry = w[i] >> (WORD_BITS - 1);
+            }
+            return runs;
+        }
+
+        // Writes the container's bits into `bits` as a full chunk bitmap.
+        // Results are built in place in their final container so that no
+        // 8 KiB bitmap is copied on the way.
+        static void fill_bits(const Container& c, ChunkBits& bits)
+        {
+            if (c.kind == Kind::Bitmap) {
+                bits = c.bits;
+                return;
+            }
+            bits.assign(CHUNK_BITS, false);
+            if (c.kind == Kind::Array) {
+                for (uint16_t v : c.values)
+                    set_in_chunk(bits.data(), v);
+            } else {
+                for (size_t i = 0; i < c.values.size(); i += 2)
+                    bits.set_range(c.values[i], static_cast<size_t>(c.values[i]) + c.values[i + 1] + 1);
+            }
+        }
+
+        // Marks `c`, whose bits are already in c.bits, as a bitmap container.
+        static void set_bitmap(Container& c, size_t cardinality)
+        {
+            c.kind = Kind::Bitmap;
+            c.cardinality = static_cast<uint32_t>(cardinality);
+            c.values = std::vector<uint16_t>();
+        }
+
+        static void make_bitmap(Container& c)
+        {
+            if (c.kind == Kind::Bitmap)
+                return;
+            fill_bits(c, c.bits);
+            set_bitmap(c, c.cardinality);
+        }
+
+        static void bitmap_to_array(Container& c)
+        {
+            std::vector<uint16_t> values(c.cardinality + 4);
+            const BitType* w = c.bits.data();
+            size_t n = 0;
+            for (size_t i = 0; i < CHUNK_WORDS; ++i)
+                n += flatten_word(w[i], i << WORD_SHIFT, values.data() + n);
+            values.resize(n);
+            c.values = std::move(values);
+            c.bits = ChunkBits();
+            c.kind = Kind::Array;
+        }
+
+        static void bitmap_to_runs(Container& c)
+        {
+            std::vector<uint16_t> runs;
+            runs.reserve(2 * run_count(c));
+            size_t pos = c.bits.find_next_one(0);
+            while (pos != ChunkBits::npos) {
+                size_t end = c.bits.find_next_zero(pos);
+                if (end == ChunkBits::npos)
+                    end = CHUNK_BITS;
+                runs.push_back(static_cast<uint16_t>(pos));
+                runs.push_back(static_cast<uint16_t>(end - pos - 1));
+                pos = end < CHUNK_BITS ? c.bits.find_next_one(end) : ChunkBits::npos;
+            }
+            c.values = std::move(runs);
+            c.bits = ChunkBits();
+            c.kind = Kind::Run;
+        }
+
+        // Array for small cardinalities, bitmap otherwise; run containers are
+        // left alone.
+        static void normalize(Container& c)
+        {
+            if (c.kind == Kind::Bitmap && c.cardinality <= ARRAY_MAX)
+                bitmap_to_array(c);
+            else if (c.kind == Kind::Array && c.cardinality > ARRAY_MAX)
+                make_bitmap(c);
+        }
+
+        // Switches to whichever of the three containers takes the fewest
+        // bytes: 2 per array value, 8 KiB per bitmap, 4 per run.
+        static void optimize(Container& c)
+        {
+            const size_t array_bytes = c.cardinality <= ARRAY_MAX ? 2 * c.cardinality : static_cast<size_t>(-1);
+            const size_t bitmap_bytes = CHUNK_BITS / 8;
+            const size_t run_bytes = 4 * run_count(c);
+            Kind best = Kind::Bitmap;
+            if (run_bytes < bitmap_bytes && run_bytes < array_bytes)
+                best = Kind::Run;
+            else if (array_bytes <= bitmap_bytes)
+                best = Kind::Array;
+            if (best == c.kind)
+                return;
+            make_bitmap(c);
+            if (best == Kind::Array)
+                bitmap_to_array(c);
+            else if (best == Kind::Run)
+                bitmap_to_runs(c);
+        }
+
+        // out = a & b; out must be a default-constructed container.
+        static void intersect(const Container& a, const Container& b, Container& out)
+        {
+            if (a.kind == Kind::Array && b.kind == Kind::Array) {
+                out.values.resize(std::min(a.values.size(), b.values.size()) + 8);
+                const size_t n = detail::intersect_arrays16(a.values.data(), a.values.size(),
+                                                            b.values.data(), b.values.size(), out.values.data());
+                out.values.resize(n);
+                out.values.shrink_to_fit();
+                out.cardinality = static_cast<uint32_t>(n);
+            } else if (a.kind == Kind::Array && b.kind == Kind::Bitmap) {
+                // Branchless probe: every value is written, kept only on a hit.
+                out.values.resize(a.values.size());
+                size_t n = 0;
+                for (uint16_t v : a.values) {
+                    out.values[n] = v;
+                    n += test_in_chunk(b.bits.data(), v);
+                }
+                out.values.resize(n);
+                out.values.shrink_to_fit();
+                out.cardinality = static_cast<uint32_t>(n);
+            } else if (a.kind == Kind::Bitmap && b.kind == Kind::Array) {
+                intersect(b, a, out);
+            } else if (a.kind == Kind::Bitmap && b.kind == Kind::Bitmap) {
+                const BitType* x = a.bits.data();
+                const BitType* y = b.bits.data();
+                const size_t card = detail::popcount_kernel(detail::binary_source<detail::and_op, 64>{x, y}, CHUNK_WORDS);
+                if (card <= ARRAY_MAX) {
+                    out.values.resize(card + 4);
+                    size_t n = 0;
+                    for (size_t i = 0; i < CHUNK_WORDS; ++i)
+                        n += flatten_word(x[i] & y[i], i << WORD_SHIFT, out.values.data() + n);
+                    out.values.resize(n);
+                    out.cardinality = static_cast<uint32_t>(card);
+                } else {
+                    out.bits.assign(CHUNK_BITS, false);
+                    detail::bitwise_kernel<detail::and_op, 64>(out.bits.data(), x, y, CHUNK_WORDS);
+                    set_bitmap(out, card);
+                }
+            } else if (a.kind == Kind::Run && b.kind == Kind::Run) {
+                // Branchless merge: every step writes a candidate run, keeps it
+                // only if non-empty, and advances the run that ends first.
+                out.values.resize(a.values.size() + b.values.size());
+                size_t i = 0, j = 0, n = 0, card = 0;
+                while (i < a.values.size() && j < b.values.size()) {
+                    const size_t as = a.values[i], ae = as + a.values[i + 1];
+                    const size_t bs = b.values[j], be = bs + b.values[j + 1];
+                    const size_t s = std::max(as, bs), e = std::min(ae, be);
+                    const bool hit = s <= e;
+                    out.values[n] = static_cast<uint16_t>(s);
+                    out.values[n + 1] = static_cast<uint16_t>(e - s);
+                    n += 2 * hit;
+                    card += hit * (e - s + 1);
+                    const bool advance_a = ae <= be;
+                    i += 2 * advance_a;
+                    j += 2 * !advance_a;
+                }
+                out.values.resize(n);
+                out.values.shrink_to_fit();
+                out.kind = Kind::Run;
+                out.cardinality = static_cast<uint32_t>(card);
+                optimize(out);
+            } else if (a.kind == Kind::Array && b.kind == Kind::Run) {
+                size_t j = 0;
+                for (uint16_t v : a.values) {
+                    while (j < b.values.size() && static_cast<size_t>(b.values[j]) + b.values[j + 1] < v)
+                        j += 2;
+                    if (j == b.values.size())
+                        break;
+                    if (b.values[j] <= v)
+                        out.values.push_back(v);
+                }
+                out.cardinality = static_cast<uint32_t>(out.values.size());
+            } else if (a.kind == Kind::Run && b.kind == Kind::Array) {
+                intersect(b, a, out);
+            } else {
+                // bitmap & run: materialise the runs as a mask and AND it in.
+                fill_bits(a.kind == Kind::Run ? a : b, out.bits);
+                const ChunkBits& other = a.kind == Kind::Run ? b.bits : a.bits;
+                detail::bitwise_kernel<detail::and_op, 64>(out.bits.data(), out.bits.data(), other.data(), CHUNK_WORDS);
+                set_bitmap(out, popcount_chunk(out.bits.data()));
+                optimize(out);
+            }
+        }
+
+        // out = a | b; out must be a default-constructed container.
+        static void unite(const Container& a, const Container& b, Container& out)
+        {
+            if (a.kind == Kind::Array && b.kind == Kind::Array) {
+                if (a.values.size() + b.values.size() <= ARRAY_MAX) {
+                    out.values.resize(a.values.size() + b.values.size());
+                    const size_t n = detail::union_arrays16(a.values.data(), a.values.size(),
+                                                            b.values.data(), b.values.size(), out.values.data());
+                    out.values.resize(n);
+                    out.cardinality = static_cast<uint32_t>(n);
+                } else {
+                    out.bits.assign(CHUNK_BITS, false);
+                    for (uint16_t v : a.values)
+                        set_in_chunk(out.bits.data(), v);
+                    for (uint16_t v : b.values)
+                        set_in_chunk(out.bits.data(), v);
+                    set_bitmap(out, popcount_chunk(out.bits.data()));
+                    normalize(out);
+                }
+            } else if (a.kind == Kind::Array && b.kind == Kind::Bitmap) {
+                out.bits = b.bits;
+                size_t card = b.cardinality;
+                for (uint16_t v : a.values) {
+                    card += !test_in_chunk(out.bits.data(), v);
+                    set_in_chunk(out.bits.data(), v);
+                }
+                set_bitmap(out, card);
+            } else if (a.kind == Kind::Bitmap && b.kind == Kind::Array) {
+                unite(b, a, out);
+            } else if (a.kind == Kind::Bitmap && b.kind == Kind::Bitmap) {
+                out.bits.assign(CHUNK_BITS, false);
+                detail::bitwise_kernel<detail::or_op, 64>(out.bits.data(), a.bits.data(), b.bits.data(), CHUNK_WORDS);
+                set_bitmap(out, popcount_chunk(out.bits.data()));
+            } else if (a.kind == Kind::Run && b.kind == Kind::Run) {
+                // Merge the runs in start order, coalescing overlapping and
+                // adjacent ones.
+                size_t i = 0, j = 0, card = 0;
+                out.values.reserve(a.values.size() + b.values.size());
+                while (i < a.values.size() || j < b.values.size()) {
+                    const bool take_a = j == b.values.size() || (i < a.values.size() && a.values[i] <= b.values[j]);
+                    const std::vector<uint16_t>& src = take_a ? a.values : b.values;
+                    size_t& k = take_a ? i : j;
+                    const size_t s = src[k], e = s + src[k + 1];
+                    k += 2;
+                    if (!out.values.empty()) {
+                        const size_t last_s = out.values[out.values.size() - 2];
+                        const size_t last_e = last_s + out.values.back();
+                        if (s <= last_e + 1) {
+                            if (e > last_e) {
+                                card += e - last_e;
+                                out.values.back() = static_cast<uint16_t>(e - last_s);
+                            }
+                            continue;
+                        }
+                    }
+                    out.values.push_back(static_cast<uint16_t>(s));
+                    out.values.push_back(static_cast<uint16_t>(e - s));
+                    card += e - s + 1;
+                }
+                out.kind = Kind::Run;
+                out.cardinality = static_cast<uint32_t>(card);
+                optimize(out);
+            } else {
+                // run | array and run | bitmap go through a bitmap.
+                const Container& run = a.kind == Kind::Run ? a : b;
+                const Container& other = a.kind == Kind::Run ? b : a;
+                if (other.kind == Kind::Bitmap) {
+                    out.bits = other.bits;
+                    for (size_t i = 0; i < run.values.size(); i += 2)
+                        out.bits.set_range(run.values[i], static_cast<size_t>(run.values[i]) + run.values[i + 1] + 1);
+                } else {
+                    fill_bits(run, out.bits);
+                    for (uint16_t v : other.values)
+                        set_in_chunk(out.bits.data(), v);
+                }
+                set_bitmap(out, popcount_chunk(out.bits.data()));
+                optimize(out);
+            }
+        }
+
+        static bool container_contains(const Container& c, uint16_t v)
+        {
+            if (c.kind == Kind::Array)
+                return std::binary_search(c.values.begin(), c.values.end(), v);
+            if (c.kind == Kind::Bitmap)
+                return test_in_chunk(c.bits.data(), v);
+            // Last run starting at or before v.
+            size_t lo = 0, hi = c.values.size() / 2;
+            while (lo < hi) {
+                const size_t mid = (lo + hi) / 2;
+                if (c.values[2 * mid] <= v)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo && v <= static_cast<size_t>(c.values[2 * (lo - 1)]) + c.values[2 * (lo - 1) + 1];
+        }
+
+        static size_t container_max(const Container& c)
+        {
+            if (c.kind == Kind::Array)
+                return c.values.back();
+            if (c.kind == Kind::Bitmap)
+                return c.bits.find_last_one();
+            return static_cast<size_t>(c.values[c.values.size() - 2]) + c.values.back();
+        }
+
+        size_t find_key(uint16_t key) const
+        {
+            return static_cast<size_t>(std::lower_bound(m_keys.begin(), m_keys.end(), key) - m_keys.begin());
+        }
+
+    public:
+        RoaringBitmap() = default;
+
+        // Compresses `bits`; bit i becomes position i.  bits.size() must not
+        // exceed 2^32.
+        template<typename Allocator, std::size_t InlineBits>
+        explicit RoaringBitmap(const BitVector<Allocator, InlineBits>& bits)
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (bits.size() > (static_cast<size_t>(1) << 32)){
+                std::stringstream  ss;
+                ss << "RoaringBitmap positions are 32-bit" << " size: " << bits.size() << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            // Count first so the containers never have to be reallocated.
+            std::vector<size_t> cards((bits.size() + CHUNK_BITS - 1) / CHUNK_BITS);
+            size_t used = 0;
+            for (size_t k = 0; k < cards.size(); ++k) {
+                cards[k] = bits.count(k * CHUNK_BITS, std::min(bits.size(), (k + 1) * CHUNK_BITS));
+                used += cards[k] != 0;
+            }
+            m_keys.reserve(used);
+            m_containers.reserve(used);
+            const BitType* data = bits.data();
+            for (size_t k = 0; k < cards.size(); ++k) {
+                if (!cards[k])
+                    continue;
+                const size_t first = k * CHUNK_BITS;
+                const size_t last = std::min(bits.size(), first + CHUNK_BITS);
+                m_keys.push_back(static_cast<uint16_t>(k));
+                m_containers.emplace_back();
+                Container& c = m_containers.back();
+                c.bits.assign(CHUNK_BITS, false);
+                const size_t words = (last - first + WORD_BITS - 1) / WORD_BITS;
+                std::copy(data + first / WORD_BITS, data + first / WORD_BITS + words, c.bits.data());
+                if ((last - first) & (WORD_BITS - 1))
+                    c.bits.data()[words - 1] &= detail::tail_mask(last - first);
+                set_bitmap(c, cards[k]);
+                optimize(c);
+            }
+        }
+
+        // Decompresses into a vector of n bits.  Every position must be below n.
+        template<typename Allocator = std::allocator<BitType>>
+        BitVector<Allocator> to_bitvector(size_t n) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (!empty() && maximum() >= n){
+                std::stringstream  ss;
+                ss << "RoaringBitmap position out of range" << " max: " << maximum() << " size: " << n << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            BitVector<Allocator> out(n);
+            BitType* data = out.data();
+            const size_t words = (n + WORD_BITS - 1) / WORD_BITS;
+            for (size_t k = 0; k < m_keys.size(); ++k) {
+                const Container& c = m_containers[k];
+                const size_t base = static_cast<size_t>(m_keys[k]) << 16;
+                if (c.kind == Kind::Bitmap) {
+                    const size_t first = base / WORD_BITS;
+                    if (first < words)
+                        std::copy(c.bits.data(), c.bits.data() + std::min(CHUNK_WORDS, words - first), data + first);
+                } else if (c.kind == Kind::Array) {
+                    for (uint16_t v : c.values) {
+                        if (base + v < n)
+                            out.set_bit_true_unsafe(base + v);
+                    }
+                } else {
+                    for (size_t i = 0; i < c.values.size(); i += 2) {
+                        const size_t s = base + c.values[i];
+                        const size_t e = std::min(n, s + c.values[i + 1] + 1);
+                        if (s < e)
+                            out.set_range(s, e);
+                    }
+                }
+            }
+            return out;
+        }
+
+        void add(uint32_t x)
+        {
+            const uint16_t key = static_cast<uint16_t>(x >> 16);
+            const uint16_t v = static_cast<uint16_t>(x);
+            const size_t k = find_key(key);
+            if (k == m_keys.size() || m_keys[k] != key) {
+                m_keys.insert(m_keys.begin() + k, key);
+                Container c;
+                c.values.push_back(v);
+                c.cardinality = 1;
+                m_containers.insert(m_containers.begin() + k, std::move(c));
+                return;
+            }
+            Container& c = m_containers[k];
+            if (c.kind == Kind::Run) {
+                if (container_contains(c, v))
+                    return;
+                make_bitmap(c);
+                normalize(c);
+            }
+            if (c.kind == Kind::Array) {
+                auto it = std::lower_bound(c.values.begin(), c.values.end(), v);
+                if (it != c.values.end() && *it == v)
+                    return;
+                c.values.insert(it, v);
+                ++c.cardinality;
+                normalize(c);
+            } else if (!test_in_chunk(c.bits.data(), v)) {
+                set_in_chunk(c.bits.data(), v);
+                ++c.cardinality;
+            }
+        }
+
+        void remove(uint32_t x)
+        {
+            const uint16_t key = static_cast<uint16_t>(x >> 16);
+            const uint16_t v = static_cast<uint16_t>(x);
+            const size_t k = find_key(key);
+            if (k == m_keys.size() || m_keys[k] != key)
+                return;
+            Container& c = m_containers[k];
+            if (!container_contains(c, v))
+                return;
+            if (c.kind == Kind::Run)
+                make_bitmap(c);
+            if (c.kind == Kind::Array)
+                c.values.erase(std::lower_bound(c.values.begin(), c.values.end(), v));
+            else
+                c.bits.data()[v >> WORD_SHIFT] &= ~(static_cast<BitType>(1) << (v & (WORD_BITS - 1)));
+            if (--c.cardinality == 0) {
+                m_keys.erase(m_keys.begin() + k);
+                m_containers.erase(m_containers.begin() + k);
+                return;
+            }
+            normalize(c);
+        }
+
+        bool contains(uint32_t x) const
+        {
+            const uint16_t key = static_cast<uint16_t>(x >> 16);
+            const size_t k = find_key(key);
+            return k < m_keys.size() && m_keys[k] == key && container_contains(m_containers[k], static_cast<uint16_t>(x));
+        }
+
+        // Number of set positions.
+        size_t cardinality() const
+        {
+            size_t total = 0;
+            for (const Container& c : m_containers)
+                total += c.cardinality;
+            return total;
+        }
+
+        bool empty() const
+        {
+            return m_keys.empty();
+        }
+
+        // Largest set position; the bitmap must not be empty.
+        size_t maximum() const
+        {
+            return (static_cast<size_t>(m_keys.back()) << 16) + container_max(m_containers.back());
+        }
+
+        // Number of non-empty 2^16-bit chunks.
+        size_t container_count() const
+        {
+            return m_keys.size();
+        }
+
+        // Re-picks the smallest container for every chunk, turning long
+        // stretches of ones into run containers.
+        void run_optimize()
+        {
+            for (Container& c : m_containers)
+                optimize(c);
+        }
+
+        // Heap and object bytes held by the bitmap.
+        size_t memory_bytes() const
+        {
+            size_t bytes = sizeof(*this) + m_keys.capacity() * sizeof(uint16_t) + m_containers.capacity() * sizeof(Container);
+            for (const Container& c : m_containers)
+                bytes += c.values.capacity() * sizeof(uint16_t) + (c.kind == Kind::Bitmap ? CHUNK_BITS / 8 : 0);
+            return bytes;
+        }
+
+        friend RoaringBitmap operator&(const RoaringBitmap& a, const RoaringBitmap& b)
+        {
+            RoaringBitmap out;
+            out.m_keys.reserve(std::min(a.m_keys.size(), b.m_keys.size()));
+            out.m_containers.reserve(std::min(a.m_keys.size(), b.m_keys.size()));
+            size_t i = 0, j = 0;
+            while (i < a.m_keys.size() && j < b.m_keys.size()) {
+                if (a.m_keys[i] < b.m_keys[j]) {
+                    ++i;
+                } else if (b.m_keys[j] < a.m_keys[i]) {
+                    ++j;
+                } else {
+                    out.m_containers.emplace_back();
+                    intersect(a.m_containers[i], b.m_containers[j], out.m_containers.back());
+                    if (out.m_containers.back().cardinality)
+                        out.m_keys.push_back(a.m_keys[i]);
+                    else
+                        out.m_containers.pop_back();
+                    ++i;
+                    ++j;
+                }
+            }
+            return out;
+        }
+
+        friend RoaringBitmap operator|(const RoaringBitmap& a, const RoaringBitmap& b)
+        {
+            RoaringBitmap out;
+            out.m_keys.reserve(a.m_keys.size() + b.m_keys.size());
+            out.m_containers.reserve(a.m_keys.size() + b.m_keys.size());
+            size_t i = 0, j = 0;
+            while (i < a.m_keys.size() || j < b.m_keys.size()) {
+                if (j == b.m_keys.size() || (i < a.m_keys.size() && a.m_keys[i] < b.m_keys[j])) {
+                    out.m_keys.push_back(a.m_keys[i]);
+                    out.m_containers.push_back(a.m_containers[i++]);
+                } else if (i == a.m_keys.size() || b.m_keys[j] < a.m_keys[i]) {
+                    out.m_keys.push_back(b.m_keys[j]);
+                    out.m_containers.push_back(b.m_containers[j++]);
+                } else {
+                    out.m_keys.push_back(a.m_keys[i]);
+                    out.m_containers.emplace_back();
+                    unite(a.m_containers[i++], b.m_containers[j++], out.m_containers.back());
+                }
+            }
+            return out;
+        }
+
+        RoaringBitmap& operator&=(const RoaringBitmap& other)
+        {
+            return *this = *this & other;
+        }
+
+        RoaringBitmap& operator|=(const RoaringBitmap& other)
+        {
+            return *this = *this | other;
+        }
+    };
+
+} // namespace bowen
+
+#endif
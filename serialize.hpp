@@ -0,0 +1,432 @@
+#ifndef BITVECTOR_SERIALIZE_H
+#define BITVECTOR_SERIALIZE_H
+
+#include "bitvector.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <unistd.h>
+
+namespace bowen
+{
+    namespace detail
+    {
+        constexpr uint32_t CRC32C_POLY = 0x82f63b78u; // Castagnoli, bit-reflected
+
+        struct crc32c_table {
+            uint32_t entry[256];
+
+            constexpr crc32c_table()
+                : entry()
+            {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; ++k)
+                        c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+                    entry[i] = c;
+                }
+            }
+        };
+
+        constexpr crc32c_table CRC32C_TABLE{};
+
+        // a * b modulo the CRC polynomial, both bit-reflected (x^0 is bit 31).
+        inline uint32_t crc32c_multmodp(uint32_t a, uint32_t b)
+        {
+            uint32_t m = static_cast<uint32_t>(1) << 31;
+            uint32_t p = 0;
+            for (;;) {
+                if (a & m) {
+                    p ^= b;
+                    if ((a & (m - 1)) == 0)
+                        break;
+                }
+                m >>= 1;
+                b = b & 1 ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+            }
+            return p;
+        }
+
+        // x^(8 * bytes) modulo the polynomial.  Multiplying a CRC state by it
+        // gives the state after `bytes` more zero bytes.
+        inline uint32_t crc32c_shift(uint64_t bytes)
+        {
+            uint32_t square = static_cast<uint32_t>(1) << 30; // x^1
+            uint32_t p = static_cast<uint32_t>(1) << 31;      // x^0
+            for (uint64_t n = bytes * 8; n; n >>= 1) {
+                if (n & 1)
+                    p = crc32c_multmodp(square, p);
+                square = crc32c_multmodp(square, square);
+            }
+            return p;
+        }
+
+        // CRC32C state update without the initial and final inversion.
+        //
+        // The crc32 instruction has a latency of three cycles but a
+        // throughput of one, so long inputs are cut into three lanes that
+        // are hashed in one interleaved loop.  The lane states are merged
+        // with crc(A B) = crc(A) * x^(8|B|) ^ crc'(B), where crc' starts
+        // from zero.
+        inline uint32_t crc32c_update(uint32_t crc, const void* data, size_t bytes)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+#if defined(__SSE4_2__)
+            constexpr size_t LANE = 4096;
+            if (bytes >= 3 * LANE) {
+                static const uint32_t shift1 = crc32c_shift(LANE);
+                static const uint32_t shift2 = crc32c_shift(2 * LANE);
+                do {
+                    uint64_t c0 = crc, c1 = 0, c2 = 0;
+                    for (size_t i = 0; i < LANE; i += 8) {
+                        uint64_t w0, w1, w2;
+                        std::memcpy(&w0, p + i, 8);
+                        std::memcpy(&w1, p + LANE + i, 8);
+                        std::memcpy(&w2, p + 2 * LANE + i, 8);
+                        c0 = _mm_crc32_u64(c0, w0);
+                        c1 = _mm_crc32_u64(c1, w1);
+                        c2 = _mm_crc32_u64(c2, w2);
+                    }
+                    crc = crc32c_multmodp(shift2, static_cast<uint32_t>(c0)) ^
+                          crc32c_multmodp(shift1, static_cast<uint32_t>(c1)) ^ static_cast<uint32_t>(c2);
+                    p += 3 * LANE;
+                    bytes -= 3 * LANE;
+                } while (bytes >= 3 * LANE);
+            }
+            uint64_t c = crc;
+            for (; bytes >= 8; bytes -= 8, p += 8) {
+                uint64_t w;
+                std::memcpy(&w, p, 8);
+                c = _mm_crc32_u64(c, w);
+            }
+            crc = static_cast<uint32_t>(c);
+            for (; bytes; --bytes)
+                crc = _mm_crc32_u8(crc, *p++);
+#else
+            for (; bytes; --bytes)
+                crc = CRC32C_TABLE.entry[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+#endif
+            return crc;
+        }
+    } // namespace detail
+
+    // CRC32C (iSCSI) of `bytes` bytes.  Pass the previous result as `crc`
+    // to continue a checksum over consecutive pieces.
+    inline uint32_t crc32c(const void* data, size_t bytes, uint32_t crc = 0)
+    {
+        return ~detail::crc32c_update(~crc, data, bytes);
+    }
+
+    // Serialized bit vector layout, version 1.  All fields are in the
+    // writer's byte order, which the header records:
+    //
+    //   0   char[8]  magic "BOWENBVF"
+    //   8   uint16   version
+    //   10  uint8    bytes per word
+    //   11  uint8    byte order: 1 little endian, 2 big endian
+    //   12  uint32   flags (SerialFormat::POPCOUNT, SerialFormat::RANK)
+    //   16  uint64   number of bits
+    //   24  uint64   number of set bits, if POPCOUNT
+    //   32  uint64   payload bytes (the words, zero padded to 64 bytes)
+    //   40  uint64   rank bytes
+    //   48  uint64   reserved, zero
+    //   56  uint32   CRC32C of everything after the header
+    //   60  uint32   CRC32C of header bytes 0-59
+    //   64  payload
+    //       rank blocks: uint64 count of set bits before every
+    //       RANK_BLOCK_BITS-bit block, one entry per block up to and
+    //       including the one holding bit `size`
+    //
+    // Bits past the size are zero in the payload.  The payload starts on a
+    // cache line, so a page-aligned buffer holds it at 64-byte alignment.
+    struct SerialFormat {
+        static constexpr char MAGIC[8] = {'B', 'O', 'W', 'E', 'N', 'B', 'V', 'F'};
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t HEADER_BYTES = 64;
+        static constexpr size_t RANK_BLOCK_BITS = 2048;
+
+        static constexpr uint32_t POPCOUNT = 1;
+        static constexpr uint32_t RANK = 2;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        static constexpr uint8_t NATIVE_ORDER = 2;
+#else
+        static constexpr uint8_t NATIVE_ORDER = 1;
+#endif
+    };
+
+    namespace detail
+    {
+        struct serial_header {
+            char magic[8];
+            uint16_t version;
+            uint8_t word_bytes;
+            uint8_t byte_order;
+            uint32_t flags;
+            uint64_t bits;
+            uint64_t popcount;
+            uint64_t payload_bytes;
+            uint64_t rank_bytes;
+            uint64_t reserved;
+            uint32_t body_crc;
+            uint32_t header_crc;
+        };
+        static_assert(sizeof(serial_header) == SerialFormat::HEADER_BYTES, "header must be one cache line");
+
+        inline size_t serial_payload_bytes(size_t bits)
+        {
+            const size_t bytes = (bits + WORD_BITS - 1) / WORD_BITS * sizeof(BitType);
+            return (bytes + SerialFormat::HEADER_BYTES - 1) / SerialFormat::HEADER_BYTES * SerialFormat::HEADER_BYTES;
+        }
+
+        inline void write_all(int fd, const void* data, size_t bytes)
+        {
+            const char* p = static_cast<const char*>(data);
+            while (bytes) {
+                const ssize_t n = ::write(fd, p, bytes);
+                if (n < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    throw std::system_error(errno, std::generic_category(), "write");
+                }
+                p += n;
+                bytes -= static_cast<size_t>(n);
+            }
+        }
+    } // namespace detail
+
+    // Writes `bits` to the file descriptor in the SerialFormat layout.
+    // `flags` selects the optional popcount and rank blocks.  The
+    // descriptor is written sequentially, so pipes and sockets work.
+    template<typename Allocator, std::size_t InlineBits>
+    void save(int fd, const BitVector<Allocator, InlineBits>& bits, uint32_t flags = SerialFormat::POPCOUNT)
+    {
+        const size_t n = bits.size();
+        const size_t words = (n + WORD_BITS - 1) / WORD_BITS;
+        const BitType* data = bits.data();
+        const BitType last = words ? data[words - 1] & detail::tail_mask(n) : 0;
+        const size_t padding = detail::serial_payload_bytes(n) - words * sizeof(BitType);
+        static const unsigned char zeros[SerialFormat::HEADER_BYTES] = {};
+
+        // The block holding the last word is never followed by another
+        // entry, so its bits past the size are never counted.
+        std::vector<uint64_t> rank;
+        if (flags & SerialFormat::RANK) {
+            constexpr size_t BLOCK_WORDS = SerialFormat::RANK_BLOCK_BITS / WORD_BITS;
+            rank.resize(n / SerialFormat::RANK_BLOCK_BITS + 1);
+            uint64_t ones = 0;
+            for (size_t b = 0; b < rank.size(); ++b) {
+                rank[b] = ones;
+                const size_t begin = std::min(words, b * BLOCK_WORDS);
+                const size_t end = std::min(words, begin + BLOCK_WORDS);
+                ones += detail::popcount_kernel(detail::word_source<>{data + begin}, end - begin);
+            }
+        }
+
+        detail::serial_header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, SerialFormat::MAGIC, sizeof(h.magic));
+        h.version = SerialFormat::VERSION;
+        h.word_bytes = sizeof(BitType);
+        h.byte_order = SerialFormat::NATIVE_ORDER;
+        h.flags = flags & (SerialFormat::POPCOUNT | SerialFormat::RANK);
+        h.bits = n;
+        h.popcount = flags & SerialFormat::POPCOUNT ? bits.count() : 0;
+        h.payload_bytes = detail::serial_payload_bytes(n);
+        h.rank_bytes = rank.size() * sizeof(uint64_t);
+
+        uint32_t crc = 0;
+        if (words) {
+            crc = crc32c(data, (words - 1) * sizeof(BitType), crc);
+            crc = crc32c(&last, sizeof(last), crc);
+        }
+        crc = crc32c(zeros, padding, crc);
+        crc = crc32c(rank.data(), h.rank_bytes, crc);
+        h.body_crc = crc;
+        h.header_crc = crc32c(&h, offsetof(detail::serial_header, header_crc));
+
+        detail::write_all(fd, &h, sizeof(h));
+        if (words) {
+            detail::write_all(fd, data, (words - 1) * sizeof(BitType));
+            detail::write_all(fd, &last, sizeof(last));
+        }
+        detail::write_all(fd, zeros, padding);
+        detail::write_all(fd, rank.data(), h.rank_bytes);
+    }
+
+    // Read-only bit vector over a serialized buffer, e.g. a mapped file or
+    // a shared memory segment.  Nothing is copied; the buffer must outlive
+    // the view.  count() uses the stored popcount and rank1() the stored
+    // rank blocks when the writer included them.
+    class BitVectorView
+    {
+    private:
+        const detail::serial_header* m_header;
+        const BitType* m_data;
+        const uint64_t* m_rank;
+        size_t m_size;
+
+        explicit BitVectorView(const detail::serial_header* h)
+            : m_header(h),
+              m_data(reinterpret_cast<const BitType*>(reinterpret_cast<const char*>(h) + SerialFormat::HEADER_BYTES)),
+              m_rank(h->flags & SerialFormat::RANK
+                         ? reinterpret_cast<const uint64_t*>(reinterpret_cast<const char*>(m_data) + h->payload_bytes)
+                         : nullptr),
+              m_size(static_cast<size_t>(h->bits)) {}
+
+        friend BitVectorView load_view(const void* buffer, size_t bytes, bool verify);
+
+    public:
+        BitVectorView()
+            : m_header(nullptr), m_data(nullptr), m_rank(nullptr), m_size(0) {}
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        // The payload words; bits past size() are zero.
+        const BitType* data() const
+        {
+            return m_data;
+        }
+
+        // Bytes of the serialized form: header, payload and rank blocks.
+        size_t serialized_bytes() const
+        {
+            return m_header ? static_cast<size_t>(SerialFormat::HEADER_BYTES + m_header->payload_bytes + m_header->rank_bytes) : 0;
+        }
+
+        bool has_popcount() const
+        {
+            return m_header && (m_header->flags & SerialFormat::POPCOUNT);
+        }
+
+        bool has_rank() const
+        {
+            return m_rank != nullptr;
+        }
+
+        bool operator[](size_t pos) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (pos >= m_size){
+                std::stringstream  ss;
+                ss << "BitVectorView index out of range" << " pos: " << pos << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            return (m_data[pos >> WORD_SHIFT] >> (pos & (WORD_BITS - 1))) & 1;
+        }
+
+        size_t count() const
+        {
+            if (has_popcount())
+                return static_cast<size_t>(m_header->popcount);
+            return detail::popcount_kernel(detail::word_source<>{m_data}, (m_size + WORD_BITS - 1) / WORD_BITS);
+        }
+
+        // Number of ones in [0, i).
+        size_t rank1(size_t i) const
+        {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+            if (i > m_size){
+                std::stringstream  ss;
+                ss << "BitVectorView rank out of range" << " i: " << i << " size: " << m_size << std::endl;
+                throw std::out_of_range(ss.str());
+            }
+#endif
+            const size_t wi = i >> WORD_SHIFT;
+            size_t first = 0;
+            size_t r = 0;
+            if (m_rank) {
+                const size_t b = i / SerialFormat::RANK_BLOCK_BITS;
+                r = static_cast<size_t>(m_rank[b]);
+                first = b * (SerialFormat::RANK_BLOCK_BITS / WORD_BITS);
+            }
+            r += detail::popcount_kernel(detail::word_source<>{m_data + first}, wi - first);
+            if (i & (WORD_BITS - 1))
+                r += detail::popcount_word(m_data[wi] & ((static_cast<BitType>(1) << (i & (WORD_BITS - 1))) - 1));
+            return r;
+        }
+
+        size_t rank0(size_t i) const
+        {
+            return i - rank1(i);
+        }
+
+        // Recomputes the body checksum.
+        bool verify() const
+        {
+            if (!m_header)
+                return true;
+            return crc32c(m_data, static_cast<size_t>(m_header->payload_bytes + m_header->rank_bytes)) == m_header->body_crc;
+        }
+
+        // Leaf for the lazy expression operators, e.g.
+        // BitVector<> r = view.expr() & other;
+        BitVectorLeaf<alignof(BitType)> expr() const
+        {
+            return BitVectorLeaf<alignof(BitType)>(m_data, m_size);
+        }
+
+        template<typename Allocator = std::allocator<BitType>>
+        BitVector<Allocator> to_bitvector() const
+        {
+            BitVector<Allocator> out(m_size);
+            std::copy(m_data, m_data + (m_size + WORD_BITS - 1) / WORD_BITS, out.data());
+            return out;
+        }
+    };
+
+    // Wraps a buffer produced by save() without copying it.  The header is
+    // always checked (magic, version, word size, byte order, lengths and
+    // header checksum); with `verify` the body checksum is checked too,
+    // which reads the whole buffer.  The buffer must be aligned to
+    // alignof(BitType).  Throws std::runtime_error on a malformed buffer.
+    inline BitVectorView load_view(const void* buffer, size_t bytes, bool verify = true)
+    {
+#ifndef BITVECTOR_NO_BOUND_CHECK
+        if (reinterpret_cast<uintptr_t>(buffer) % alignof(BitType)){
+            std::stringstream  ss;
+            ss << "load_view buffer is misaligned" << " address: " << buffer << std::endl;
+            throw std::invalid_argument(ss.str());
+        }
+#endif
+        if (bytes < SerialFormat::HEADER_BYTES)
+            throw std::runtime_error("load_view: buffer shorter than the header");
+        const detail::serial_header* h = static_cast<const detail::serial_header*>(buffer);
+        if (std::memcmp(h->magic, SerialFormat::MAGIC, sizeof(h->magic)) != 0)
+            throw std::runtime_error("load_view: not a serialized bit vector");
+        if (h->byte_order != SerialFormat::NATIVE_ORDER || h->word_bytes != sizeof(BitType))
+            throw std::runtime_error("load_view: written with a different byte order or word size");
+        if (h->version != SerialFormat::VERSION)
+            throw std::runtime_error("load_view: unsupported version " + std::to_string(h->version));
+        if (crc32c(h, offsetof(detail::serial_header, header_crc)) != h->header_crc)
+            throw std::runtime_error("load_view: header checksum mismatch");
+        const bool rank = h->flags & SerialFormat::RANK;
+        // Bounding bits by the buffer first keeps the size arithmetic below
+        // from wrapping on a forged count.
+        if (h->bits / 8 > bytes - SerialFormat::HEADER_BYTES ||
+            h->payload_bytes != detail::serial_payload_bytes(static_cast<size_t>(h->bits)) ||
+            h->rank_bytes != (rank ? (h->bits / SerialFormat::RANK_BLOCK_BITS + 1) * sizeof(uint64_t) : 0) ||
+            bytes - SerialFormat::HEADER_BYTES < h->payload_bytes + h->rank_bytes)
+            throw std::runtime_error("load_view: truncated or inconsistent buffer");
+        BitVectorView view(h);
+        if (verify && !view.verify())
+            throw std::runtime_error("load_view: payload checksum mismatch");
+        return view;
+    }
+
+} // namespace bowen
+
+#endif
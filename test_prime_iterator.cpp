@@ -0,0 +1,58 @@
+#include "prime_sieve.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+static std::vector<uint64_t> naive_primes(uint64_t limit) {
+    std::vector<uint64_t> primes;
+    for (uint64_t n = 2; n < limit; ++n) {
+        bool prime = true;
+        for (uint64_t d = 2; d * d <= n; ++d) {
+            if (n % d == 0) {
+                prime = false;
+                break;
+            }
+        }
+        if (prime)
+            primes.push_back(n);
+    }
+    return primes;
+}
+
+TEST(PrimeIteratorTest, MatchesTrialDivision) {
+    const uint64_t limit = 20000;
+    const std::vector<uint64_t> expected = naive_primes(limit);
+    // Tiny segments put many segment boundaries inside the range.
+    for (size_t segment_bits : {64u, 100u, 1000u, 1u << 21}) {
+        bowen::PrimeSieve sieve(limit, segment_bits);
+        std::vector<uint64_t> primes;
+        for (uint64_t p : sieve)
+            primes.push_back(p);
+        EXPECT_EQ(primes, expected) << "segment_bits=" << segment_bits;
+        EXPECT_EQ(sieve.count(), expected.size());
+    }
+}
+
+TEST(PrimeIteratorTest, SmallLimits) {
+    EXPECT_EQ(bowen::PrimeSieve(0).count(), 0u);
+    EXPECT_EQ(bowen::PrimeSieve(2).count(), 0u);
+    EXPECT_EQ(bowen::PrimeSieve(3).count(), 1u);
+    EXPECT_EQ(bowen::PrimeSieve(10).count(), 4u);
+
+    bowen::PrimeSieve two(2);
+    EXPECT_TRUE(bowen::begin(two) == bowen::end(two));
+
+    bowen::PrimeSieve ten(10);
+    auto it = bowen::begin(ten);
+    EXPECT_EQ(*it++, 2u);
+    EXPECT_EQ(*it++, 3u);
+    EXPECT_EQ(*it++, 5u);
+    EXPECT_EQ(*it++, 7u);
+    EXPECT_TRUE(it == bowen::end(ten));
+}
+
+TEST(PrimeIteratorTest, KnownCountsAndThreads) {
+    EXPECT_EQ(bowen::PrimeSieve(1000000).count(), 78498u);
+    bowen::PrimeSieve sieve(10000000, 1 << 16);
+    EXPECT_EQ(sieve.count(4), 664579u);
+    EXPECT_EQ(sieve.count(1), 664579u);
+}